@@ -0,0 +1,78 @@
+#ifndef ALLOC_STATS_H
+#define ALLOC_STATS_H
+
+#include <stddef.h>
+#include "time_report.h"
+
+/**
+ * @brief Allocation counts for one phase.
+ */
+typedef struct {
+    long allocations;        /* malloc, strdup and realloc calls */
+    long bytes_requested;    /* Bytes asked for by those calls */
+    long realloc_copy_bytes; /* Bytes realloc had to move to a new block */
+    long peak_live_bytes;    /* Most bytes allocated at once while the phase allocated or freed */
+} AllocationCounts;
+
+/**
+ * @brief Allocation counts per phase, and outside any phase.
+ */
+typedef struct {
+    AllocationCounts phases[PHASE_COUNT + 1]; /* Indexed by Phase; PHASE_COUNT is outside any phase */
+    long peak_live_bytes;
+    int files;
+} MemoryReport;
+
+/**
+ * @brief The counts recorded since the last call to start_memory_report().
+ */
+extern MemoryReport memory_usage;
+
+/**
+ * @brief Allocates memory and counts it against the current phase.
+ * @param size The number of bytes to allocate.
+ * @return Pointer to the memory, or NULL on failure. Free it with counted_free().
+ */
+void *counted_malloc(size_t size);
+
+/**
+ * @brief Resizes memory from counted_malloc() and counts it against the current phase.
+ * @param ptr Pointer to the memory, or NULL.
+ * @param size The new size in bytes.
+ * @return Pointer to the resized memory, or NULL on failure (ptr is then left unchanged).
+ */
+void *counted_realloc(void *ptr, size_t size);
+
+/**
+ * @brief Duplicates a string into counted memory.
+ * @param str The string to duplicate.
+ * @return Pointer to the copy, or NULL on failure. Free it with counted_free().
+ */
+char *counted_strdup(const char *str);
+
+/**
+ * @brief Frees memory from counted_malloc(), counted_realloc() or counted_strdup().
+ * @param ptr Pointer to the memory, or NULL.
+ */
+void counted_free(void *ptr);
+
+/**
+ * @brief Clears memory_usage; the overall peak starts from the bytes that are live now.
+ */
+void start_memory_report(void);
+
+/**
+ * @brief Adds the counts of one report to another; peaks take the larger value.
+ * @param total Pointer to the report to add to.
+ * @param report Pointer to the report to add.
+ */
+void add_memory_report(MemoryReport *total, const MemoryReport *report);
+
+/**
+ * @brief Prints a memory report with one row per phase.
+ * @param report Pointer to the report to print.
+ * @param title What the report is for, such as a file name.
+ */
+void print_memory_report(const MemoryReport *report, const char *title);
+
+#endif 
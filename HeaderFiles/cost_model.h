@@ -0,0 +1,71 @@
+#ifndef COST_MODEL_H
+#define COST_MODEL_H
+
+#define MAX_LABEL_LENGTH 31
+
+/**
+ * @brief Estimated static cost of one instruction.
+ */
+typedef struct {
+    int words;           /* Machine words, as counted by get_instruction_length() */
+    int memory_accesses; /* Data memory reads and writes, including the stack */
+    int cycles;          /* One cycle per word fetched plus one per memory access */
+} InstructionCost;
+
+/**
+ * @brief Accumulated cost of the lines following one label.
+ */
+typedef struct {
+    char label[MAX_LABEL_LENGTH + 1];
+    int code_words;
+    int data_words;
+    int cycles;
+} LabelCost;
+
+/**
+ * @brief Represents the per-label cost report of one file.
+ */
+typedef struct {
+    LabelCost *entries;
+    int count;
+    int capacity;
+} CostReport;
+
+/**
+ * @brief Estimates the static cost of an instruction.
+ * @param operation The operation part of the instruction.
+ * @param operands The operands part of the instruction.
+ * @return The estimated cost; words is -1 if the instruction is invalid.
+ */
+InstructionCost get_instruction_cost(const char *operation, const char *operands);
+
+/**
+ * @brief Initializes the cost report.
+ * @param report Pointer to the cost report to initialize.
+ */
+void init_cost_report(CostReport *report);
+
+/**
+ * @brief Adds the cost of one line to the report.
+ * @param report Pointer to the cost report.
+ * @param label The label defined on the line, or an empty string.
+ * @param code_words The number of instruction words the line emits.
+ * @param data_words The number of data words the line emits.
+ * @param cycles The estimated cycles of the line.
+ */
+void add_line_cost(CostReport *report, const char *label, int code_words, int data_words, int cycles);
+
+/**
+ * @brief Prints the cost report to stdout.
+ * @param report Pointer to the cost report.
+ * @param filename The name of the file the report belongs to.
+ */
+void print_cost_report(const CostReport *report, const char *filename);
+
+/**
+ * @brief Frees the memory allocated for the cost report.
+ * @param report Pointer to the cost report to free.
+ */
+void free_cost_report(CostReport *report);
+
+#endif 
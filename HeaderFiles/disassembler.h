@@ -0,0 +1,54 @@
+#ifndef DISASSEMBLER_H
+#define DISASSEMBLER_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "isa_tables.h"
+
+#define MEMORY_SIZE 4096
+#define FIRST_ADDRESS 100
+#define MAX_LABEL_LENGTH 31
+
+/**
+ * @brief Represents an object image loaded from .ob, .ent and .ext files.
+ *
+ * Words are stored at their load address. The first code_length words from
+ * FIRST_ADDRESS are instructions, and the data_length words after them are data.
+ */
+typedef struct {
+    unsigned int words[MEMORY_SIZE];
+    int code_length;
+    int data_length;
+    char labels[MEMORY_SIZE][MAX_LABEL_LENGTH + 1];    /* Label defined at each address, or "" */
+    char externals[MEMORY_SIZE][MAX_LABEL_LENGTH + 1]; /* External referenced by each word, or "" */
+    bool entries[MEMORY_SIZE];                         /* Whether the label at each address is an entry */
+} ObjectImage;
+
+/**
+ * @brief Decodes the first word of an instruction with a single table lookup.
+ * @param word The 15-bit first word.
+ * @return The decoded fields; opcode is -1 if the word is not a valid first word.
+ */
+DecodedWord decode_first_word(unsigned int word);
+
+/**
+ * @brief Loads an object image from <base_name>.ob and, if present, .ent and .ext.
+ * @param base_name The base name of the files (without extension).
+ * @return Pointer to the loaded image, or NULL on error.
+ */
+ObjectImage *load_object_image(const char *base_name);
+
+/**
+ * @brief Frees an object image.
+ * @param image Pointer to the image to free.
+ */
+void free_object_image(ObjectImage *image);
+
+/**
+ * @brief Writes an object image as assembly source that reassembles to the same words.
+ * @param image Pointer to the image; missing labels are added to it.
+ * @param output The file to write the assembly text to.
+ */
+void disassemble_image(ObjectImage *image, FILE *output);
+
+#endif
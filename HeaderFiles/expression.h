@@ -0,0 +1,35 @@
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include <stdbool.h>
+#include "symbol_table.h"
+
+/**
+ * @brief The result of evaluating a constant expression.
+ */
+typedef struct {
+    int value;       /* The folded value */
+    int relocations; /* Net count of label addresses in the value: 1 for an address, 0 for a constant */
+} ExpressionValue;
+
+/**
+ * @brief Checks if an operand or data value is an expression rather than a single number or label.
+ * @param text The text to check, without a leading '#'.
+ * @return true if the text contains a '+', '-' or '*' after its first character, false otherwise.
+ */
+bool is_expression(const char *text);
+
+/**
+ * @brief Evaluates a constant expression such as LABEL+3, SIZE*2 or END-START.
+ *
+ * Terms are numbers and internal labels, combined with '+', '-' and '*' ('*' binds
+ * tighter) and written without spaces. A label stands for its address.
+ *
+ * @param text The expression, without a leading '#'.
+ * @param symbol_table Pointer to the symbol table.
+ * @param result Set to the folded value if the expression is valid.
+ * @return true if the expression was evaluated, false if it is malformed or uses an unknown or external label.
+ */
+bool evaluate_expression(const char *text, SymbolTable *symbol_table, ExpressionValue *result);
+
+#endif 
@@ -13,7 +13,7 @@
  * @brief Performs the first pass of the assembler.
  * @param filename The name of the input file.
  * @param symbol_table Pointer to the symbol table.
- * @return true if the first pass was successful, false otherwise.
+ * @return true if the first pass and the second pass it runs were successful, false otherwise.
  */
 bool first_pass(const char *filename, SymbolTable *symbol_table);
 
@@ -0,0 +1,73 @@
+#ifndef ISA_TABLES_H
+#define ISA_TABLES_H
+
+#include "opcode_table.h"
+
+#define MNEMONIC_HASH_SIZE 64
+#define DECODE_TABLE_SIZE (1 << 15)
+
+/**
+ * @brief Precomputed encoding of one opcode and addressing mode combination.
+ */
+typedef struct {
+    unsigned short first_word; /* The complete first word, A.R.E. included */
+    unsigned char legal;       /* 1 if the opcode allows these addressing modes, 0 otherwise */
+} EncodingEntry;
+
+/**
+ * @brief Represents the decoded fields of an instruction's first word.
+ */
+typedef struct {
+    signed char opcode;      /* Opcode, or -1 if the word is not a valid first word */
+    signed char source_mode; /* Source addressing mode (0-3), or 4 if there is no source */
+    signed char target_mode; /* Target addressing mode (0-3), or 4 if there is no target */
+    signed char length;      /* Length of the instruction in words */
+} DecodedWord;
+
+/*
+ * The tables below are generated at build time by gen_isa_tables from the
+ * instruction set description (isa_description.txt) into isa_tables.c.
+ */
+
+/**
+ * @brief The opcode table, indexed by opcode. Unused opcodes have an empty mnemonic.
+ */
+extern const OpcodeEntry opcode_table[OPCODE_COUNT];
+
+/**
+ * @brief Seed of the perfect hash over the mnemonics.
+ */
+extern const unsigned int mnemonic_hash_seed;
+
+/**
+ * @brief Opcode of the mnemonic in each hash slot, or -1 for an empty slot.
+ */
+extern const signed char mnemonic_hash_table[MNEMONIC_HASH_SIZE];
+
+/**
+ * @brief First words and legality flags, indexed by opcode, source mode and target mode.
+ * Mode 4 stands for a missing operand.
+ */
+extern const EncodingEntry encoding_table[OPCODE_COUNT][MODE_COUNT][MODE_COUNT];
+
+/**
+ * @brief Decoded fields of every 15-bit word, indexed by the word itself.
+ */
+extern const DecodedWord decode_table[DECODE_TABLE_SIZE];
+
+/**
+ * @brief Hashes a mnemonic into a slot of mnemonic_hash_table.
+ * Shared by the generator, which searches for a collision-free seed, and get_opcode().
+ * @param mnemonic The mnemonic to hash.
+ * @param seed The hash seed.
+ * @return The slot index.
+ */
+static inline unsigned int hash_mnemonic(const char *mnemonic, unsigned int seed) {
+    unsigned int hash = seed;
+    while (*mnemonic) {
+        hash = hash * 33 + (unsigned char)*mnemonic++;
+    }
+    return hash % MNEMONIC_HASH_SIZE;
+}
+
+#endif 
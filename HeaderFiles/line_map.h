@@ -0,0 +1,47 @@
+#ifndef LINE_MAP_H
+#define LINE_MAP_H
+
+/**
+ * @brief A run of consecutive addresses produced by one source line.
+ */
+typedef struct {
+    int start_address;  /* First address of the range */
+    int end_address;    /* Last address of the range (inclusive) */
+    int source_line;    /* Line number in the original .as file */
+    int expansion_line; /* Line of the macro call that produced it, or 0 */
+} LineRange;
+
+/**
+ * @brief Represents the address-to-source line table, sorted by address.
+ */
+typedef struct {
+    LineRange *ranges;
+    int count;
+    int capacity;
+} LineMap;
+
+/**
+ * @brief Initializes the line map.
+ * @param map Pointer to the line map to initialize.
+ */
+void init_line_map(LineMap *map);
+
+/**
+ * @brief Adds a range of addresses to the line map.
+ * Ranges must be added in ascending address order; a range that directly
+ * continues the previous one from the same line is merged into it.
+ * @param map Pointer to the line map.
+ * @param start_address The first address of the range.
+ * @param length The number of words in the range.
+ * @param source_line The line number in the original .as file.
+ * @param expansion_line The line of the macro call, or 0.
+ */
+void add_line_range(LineMap *map, int start_address, int length, int source_line, int expansion_line);
+
+/**
+ * @brief Frees the memory allocated for the line map.
+ * @param map Pointer to the line map to free.
+ */
+void free_line_map(LineMap *map);
+
+#endif 
@@ -1,6 +1,20 @@
 #ifndef OPCODE_TABLE_H
 #define OPCODE_TABLE_H
 
+#define OPCODE_COUNT 16
+#define MODE_COUNT 5 /* Addressing modes 0-3, plus 4 for a missing operand */
+
+/* Bitmasks of addressing modes, bit n set if mode n is allowed */
+#define MODE_BIT(mode) (1 << (mode))
+#define NO_OPERAND MODE_BIT(4)
+
+/* Effects of an instruction on its operands and control flow */
+#define EFFECT_READS_SOURCE  0x01 /* Reads the value of the source operand */
+#define EFFECT_READS_TARGET  0x02 /* Reads the value of the target operand */
+#define EFFECT_WRITES_TARGET 0x04 /* Stores a value in the target operand */
+#define EFFECT_USES_STACK    0x08 /* Pushes or pops a return address */
+#define EFFECT_ENDS_FLOW     0x10 /* Never continues to the next instruction */
+
 /**
  * @brief Represents an entry in the opcode table.
  */
@@ -8,6 +22,9 @@ typedef struct {
     char mnemonic[5];
     int opcode;
     int operands;
+    int source_modes; /* Bitmask of legal source addressing modes */
+    int target_modes; /* Bitmask of legal target addressing modes */
+    int effects;      /* Bitmask of EFFECT_* flags */
 } OpcodeEntry;
 
 /**
@@ -24,4 +41,25 @@ int get_opcode(const char *mnemonic);
  */
 int get_operand_count(const char *mnemonic);
 
+/**
+ * @brief Gets the opcode table entry for a given opcode.
+ * @param opcode The opcode to look up.
+ * @return Pointer to the entry if the opcode is valid, NULL otherwise.
+ */
+const OpcodeEntry *get_opcode_entry(int opcode);
+
+/**
+ * @brief Gets the mnemonic for a given opcode.
+ * @param opcode The opcode to look up.
+ * @return The mnemonic if the opcode is valid, NULL otherwise.
+ */
+const char *get_mnemonic(int opcode);
+
+/**
+ * @brief Gets the effects of a given mnemonic.
+ * @param mnemonic The mnemonic to look up.
+ * @return The bitmask of EFFECT_* flags if found, 0 otherwise.
+ */
+int get_effects(const char *mnemonic);
+
 #endif 
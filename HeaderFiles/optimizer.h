@@ -0,0 +1,39 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <stdbool.h>
+#include "symbol_table.h"
+
+#define MAX_LINE_LENGTH 80
+#define FIRST_ADDRESS 100
+
+/**
+ * @brief Runs the optimizer over the expanded source file.
+ *
+ * Removes no-op instructions and unreachable code, shortens mov #0 to clr and
+ * drops jumps to the next instruction. The file is rewritten in place with the same number of lines, so
+ * line numbers stay valid; removed instructions become comment lines. A file with address
+ * expressions such as LABEL+3 is left unchanged, since their targets would move.
+ * Reachability and writes come from the effects in the instruction set description; the
+ * rewrites name mov, add, sub, jmp and clr and only apply while those keep their usual effects.
+ *
+ * @param filename The name of the expanded (.am) file.
+ * @param symbol_table Pointer to the symbol table built by the first pass.
+ * @return true if the file was changed and addresses must be recomputed, false otherwise.
+ */
+bool optimize_code(const char *filename, SymbolTable *symbol_table);
+
+/**
+ * @brief Merges identical .data and .string blocks in the expanded source file.
+ *
+ * A labeled block is merged only when no instruction writes to it or takes its address,
+ * no constant expression uses its label and it is not an entry; references to its label
+ * are renamed to the kept copy. An unlabeled block is dropped when an earlier block has the
+ * same words and the label before it is not pinned that way, since nothing can address it.
+ *
+ * @param filename The name of the expanded (.am) file.
+ * @return true if the file was changed and addresses must be recomputed, false otherwise.
+ */
+bool pool_data_blocks(const char *filename);
+
+#endif 
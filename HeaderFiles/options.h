@@ -0,0 +1,38 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <stdbool.h>
+
+/**
+ * @brief Command-line options that change what the assembler produces.
+ */
+typedef struct {
+    bool emit_line_map; /**< Write a .lin address-to-source line table */
+    bool cost_report;   /**< Print estimated code size and cycles per label */
+    bool verify;        /**< Check each object file by a disassemble/reassemble round trip */
+    bool optimize;      /**< Run the optimizer between the first and second pass */
+    bool pool_data;     /**< Merge identical .data and .string blocks */
+    bool time_report;   /**< Print the time spent in each phase */
+    bool memory_report; /**< Print the allocations made in each phase */
+} AssemblerOptions;
+
+/**
+ * @brief The options in effect for the current run.
+ */
+extern AssemblerOptions assembler_options;
+
+/**
+ * @brief Checks if a command-line argument is an option rather than a file name.
+ * @param arg The argument to check.
+ * @return true if the argument starts with '-', false otherwise.
+ */
+bool is_option(const char *arg);
+
+/**
+ * @brief Applies a command-line option to assembler_options.
+ * @param arg The option, including its leading dashes.
+ * @return true if the option was recognized, false otherwise.
+ */
+bool parse_option(const char *arg);
+
+#endif 
@@ -2,6 +2,7 @@
 #define OUTPUT_GENERATOR_H
 
 #include "symbol_table.h" 
+#include "line_map.h"
 
 #define MEMORY_SIZE 4096
 #define FIRST_ADDRESS 100
@@ -12,8 +13,9 @@
  * @param symbol_table Pointer to the symbol table.
  * @param IC Instruction Counter.
  * @param DC Data Counter.
+ * @param line_map Pointer to the address-to-source line map, or NULL to skip the .lin file.
  */
-void generate_output(const char *input_filename, SymbolTable *symbol_table, int IC, int DC);
+void generate_output(const char *input_filename, SymbolTable *symbol_table, int IC, int DC, const LineMap *line_map);
 
 /**
  * @brief Generates the object (.ob) file.
@@ -38,4 +40,11 @@ void generate_ent_file(const char *base_name, SymbolTable *symbol_table);
  */
 void generate_ext_file(const char *base_name, SymbolTable *symbol_table);
 
+/**
+ * @brief Generates the line map (.lin) file.
+ * @param base_name The base name for the output file.
+ * @param line_map Pointer to the address-to-source line map.
+ */
+void generate_lin_file(const char *base_name, const LineMap *line_map);
+
 #endif 
@@ -18,6 +18,7 @@ typedef struct {
     char **lines;
     int line_count;
     int line_capacity;
+    int first_line; /* Line number of the first body line in the .as file */
 } Macro;
 
 /**
@@ -32,11 +33,47 @@ typedef struct {
 
 MacroTable macro_table;
 
+/**
+ * @brief Records where a line of the expanded (.am) file came from.
+ */
+typedef struct {
+    int source_line;    /* Line number in the original .as file */
+    int expansion_line; /* Line of the macro call that produced it, or 0 */
+} LineOrigin;
+
+/**
+ * @brief Origins of the expanded file's lines, indexed by .am line number - 1.
+ */
+typedef struct {
+    LineOrigin *origins;
+    int count;
+    int capacity;
+} LineOriginTable;
+
+extern LineOriginTable line_origins;
+
 /**
  * @brief Initializes the macro table.
  */
 void init_macro_table(void);
 
+/**
+ * @brief Initializes the line origin table.
+ */
+void init_line_origins(void);
+
+/**
+ * @brief Appends the origin of the next line written to the expanded file.
+ * @param source_line The line number in the original .as file.
+ * @param expansion_line The line of the macro call, or 0 for ordinary lines.
+ */
+void add_line_origin(int source_line, int expansion_line);
+
+/**
+ * @brief Frees the memory allocated for the line origin table.
+ */
+void free_line_origins(void);
+
 /**
  * @brief Adds a macro to the macro table.
  * @param name The name of the macro.
@@ -0,0 +1,81 @@
+#ifndef TIME_REPORT_H
+#define TIME_REPORT_H
+
+#include <stdbool.h>
+
+/**
+ * @brief The phases of assembling one file.
+ */
+typedef enum {
+    PHASE_PRE_ASSEMBLY,
+    PHASE_FIRST_PASS,
+    PHASE_SECOND_PASS,
+    PHASE_OUTPUT,
+    PHASE_COUNT
+} Phase;
+
+/**
+ * @brief Wall and CPU time spent in each phase, and the size of the input.
+ *
+ * Times are exclusive: while a phase runs a nested phase (the first pass runs
+ * the second pass, which generates the output), the time goes to the nested phase.
+ */
+typedef struct {
+    double wall_seconds[PHASE_COUNT];
+    double cpu_seconds[PHASE_COUNT];
+    long lines; /* Lines of .as source */
+    long bytes; /* Bytes of .as source */
+    int files;
+} TimeReport;
+
+/**
+ * @brief The times recorded for the file being assembled.
+ */
+extern TimeReport phase_times;
+
+/**
+ * @brief Clears a time report.
+ * @param report Pointer to the report to clear.
+ */
+void reset_time_report(TimeReport *report);
+
+/**
+ * @brief Starts timing a phase into phase_times, pausing the phase that was running.
+ * @param phase The phase that starts.
+ */
+void start_phase(Phase phase);
+
+/**
+ * @brief Stops timing the current phase and resumes the phase that was running before it.
+ */
+void end_phase(void);
+
+/**
+ * @brief Returns the innermost running phase.
+ * @return The phase, or PHASE_COUNT if no phase is running.
+ */
+Phase get_current_phase(void);
+
+/**
+ * @brief Counts the lines and bytes of a source file into a report.
+ * @param filename The name of the source file.
+ * @param report Pointer to the report to update.
+ * @return true if the file could be read, false otherwise.
+ */
+bool measure_source(const char *filename, TimeReport *report);
+
+/**
+ * @brief Adds the times and sizes of one report to another.
+ * @param total Pointer to the report to add to.
+ * @param report Pointer to the report to add.
+ */
+void add_time_report(TimeReport *total, const TimeReport *report);
+
+/**
+ * @brief Prints a time report with lines and bytes per second for each phase.
+ * @param report Pointer to the report to print.
+ * @param title What the report is for, such as a file name.
+ */
+void print_time_report(const TimeReport *report, const char *title);
+
+#endif 
@@ -46,6 +46,23 @@ int get_addressing_mode(const char *operand);
  */
 int get_instruction_length(const char *operation, const char *operands);
 
+/**
+ * @brief Split the operands of an instruction into source and target.
+ * @param operands The operands part of the instruction, or NULL.
+ * @param source Buffer of MAX_LINE_LENGTH + 1 characters for the source operand.
+ * @param target Buffer of MAX_LINE_LENGTH + 1 characters for the target operand.
+ * @return true if both operands fit in their buffers, false if one was cut short.
+ */
+bool split_operands(const char *operands, char *source, char *target);
+
+/**
+ * @brief Check if an instruction's addressing modes are allowed for its opcode.
+ * @param operation The operation part of the instruction.
+ * @param operands The operands part of the instruction.
+ * @return true if the addressing modes are legal, false otherwise.
+ */
+bool is_legal_addressing(const char *operation, const char *operands);
+
 /**
  * @brief Count the number of data values in a data directive.
  * @param operands The operands of the data directive.
@@ -68,11 +85,10 @@ Instruction encode_instruction(const char *operation, const char *operands, Symb
  * @param operand The operand to encode.
  * @param symbol_table Pointer to the symbol table.
  * @param are Pointer to the A.R.E. value.
- * @param address The current address.
- * @param is_source True if this is the source operand, false if it's the target.
+ * @param word_address The address of the word that will hold the operand.
  * @return The encoded operand value.
  */
-int encode_operand(const char *operand, SymbolTable *symbol_table, unsigned int *are, int address, bool is_source);
+int encode_operand(const char *operand, SymbolTable *symbol_table, unsigned int *are, int word_address);
 
 /**
  * @brief Write an encoded instruction to a file.
@@ -85,10 +101,12 @@ void write_instruction(FILE *file, Instruction inst, int address);
 /**
  * @brief Write data values to a file.
  * @param file The file to write to.
- * @param data The data string to write.
+ * @param data The data string to write; values may be label-free constant expressions.
  * @param address Pointer to the current address (will be updated).
+ * @param symbol_table Pointer to the symbol table, for labels in expressions.
+ * @return true if every value was valid, false otherwise.
  */
-void write_data(FILE *file, const char *data, int *address);
+bool write_data(FILE *file, const char *data, int *address, SymbolTable *symbol_table);
 
 /**
  * @brief Write a string to a file.
@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "alloc_stats.h"
+
+/**
+ * @brief Header stored in front of each counted block, so frees and reallocs know its size.
+ */
+typedef union {
+    size_t size;
+    long double align; /* Keeps the block after the header aligned for any type */
+} BlockHeader;
+
+MemoryReport memory_usage = {{{0}}};
+
+static long live_bytes = 0;
+
+static const char *phase_names[PHASE_COUNT + 1] = {"Pre-assembly", "First pass", "Second pass", "Output", "Other"};
+
+/**
+ * Finds the counts to update for an allocation.
+ * @return The counts of the phase that is running, or of "Other" outside any phase.
+ */
+static AllocationCounts *current_counts(void) {
+    return &memory_usage.phases[get_current_phase()];
+}
+
+/**
+ * Updates the live byte count and the peaks of the current phase and the whole report.
+ * @param change The number of bytes allocated (positive) or freed (negative).
+ */
+static void update_live_bytes(long change) {
+    live_bytes += change;
+    AllocationCounts *counts = current_counts();
+    if (live_bytes > counts->peak_live_bytes) {
+        counts->peak_live_bytes = live_bytes;
+    }
+    if (live_bytes > memory_usage.peak_live_bytes) {
+        memory_usage.peak_live_bytes = live_bytes;
+    }
+}
+
+/**
+ * Allocates memory with a size header and counts it against the current phase.
+ * @param size The number of bytes to allocate.
+ * @return Pointer to the memory after the header, or NULL on failure.
+ */
+void *counted_malloc(size_t size) {
+    BlockHeader *header = malloc(sizeof(BlockHeader) + size);
+    if (!header) {
+        return NULL;
+    }
+    header->size = size;
+    AllocationCounts *counts = current_counts();
+    counts->allocations++;
+    counts->bytes_requested += size;
+    update_live_bytes(size);
+    return header + 1;
+}
+
+/**
+ * Resizes counted memory. When realloc moves the block, the bytes it kept count as copied.
+ * @param ptr Pointer to the memory, or NULL.
+ * @param size The new size in bytes.
+ * @return Pointer to the resized memory, or NULL on failure.
+ */
+void *counted_realloc(void *ptr, size_t size) {
+    if (!ptr) {
+        return counted_malloc(size);
+    }
+    BlockHeader *old_header = (BlockHeader *)ptr - 1;
+    size_t old_size = old_header->size;
+    BlockHeader *header = realloc(old_header, sizeof(BlockHeader) + size);
+    if (!header) {
+        return NULL;
+    }
+    AllocationCounts *counts = current_counts();
+    if (header != old_header) {
+        counts->realloc_copy_bytes += old_size < size ? old_size : size;
+    }
+    header->size = size;
+    counts->allocations++;
+    counts->bytes_requested += size;
+    update_live_bytes((long)size - (long)old_size);
+    return header + 1;
+}
+
+/**
+ * Duplicates a string into counted memory.
+ * @param str The string to duplicate.
+ * @return Pointer to the copy, or NULL on failure.
+ */
+char *counted_strdup(const char *str) {
+    size_t size = strlen(str) + 1;
+    char *copy = counted_malloc(size);
+    if (copy) {
+        memcpy(copy, str, size);
+    }
+    return copy;
+}
+
+/**
+ * Frees counted memory.
+ * @param ptr Pointer to the memory, or NULL.
+ */
+void counted_free(void *ptr) {
+    if (!ptr) {
+        return;
+    }
+    BlockHeader *header = (BlockHeader *)ptr - 1;
+    update_live_bytes(-(long)header->size);
+    free(header);
+}
+
+/**
+ * Clears memory_usage. Memory that is still allocated (such as the error log) stays live,
+ * so the overall peak starts from the current live byte count.
+ */
+void start_memory_report(void) {
+    memset(&memory_usage, 0, sizeof(memory_usage));
+    memory_usage.peak_live_bytes = live_bytes;
+    memory_usage.files = 1;
+}
+
+/**
+ * Adds the counts of one report to another; peaks take the larger value.
+ * @param total Pointer to the report to add to.
+ * @param report Pointer to the report to add.
+ */
+void add_memory_report(MemoryReport *total, const MemoryReport *report) {
+    for (int phase = 0; phase <= PHASE_COUNT; phase++) {
+        AllocationCounts *sum = &total->phases[phase];
+        const AllocationCounts *counts = &report->phases[phase];
+        sum->allocations += counts->allocations;
+        sum->bytes_requested += counts->bytes_requested;
+        sum->realloc_copy_bytes += counts->realloc_copy_bytes;
+        if (counts->peak_live_bytes > sum->peak_live_bytes) {
+            sum->peak_live_bytes = counts->peak_live_bytes;
+        }
+    }
+    if (report->peak_live_bytes > total->peak_live_bytes) {
+        total->peak_live_bytes = report->peak_live_bytes;
+    }
+    total->files += report->files;
+}
+
+/**
+ * Prints a memory report: allocation count, bytes requested, bytes moved by realloc
+ * and peak live bytes for each phase, then the totals.
+ * @param report Pointer to the report to print.
+ * @param title What the report is for, such as a file name.
+ */
+void print_memory_report(const MemoryReport *report, const char *title) {
+    long allocations = 0, bytes_requested = 0, realloc_copy_bytes = 0;
+
+    printf("Memory report for %s (%d file%s)\n", title, report->files, report->files == 1 ? "" : "s");
+    printf("%-13s %8s %12s %12s %12s\n", "Phase", "Allocs", "Bytes", "Realloc copy", "Peak live");
+    for (int phase = 0; phase <= PHASE_COUNT; phase++) {
+        const AllocationCounts *counts = &report->phases[phase];
+        printf("%-13s %8ld %12ld %12ld %12ld\n", phase_names[phase], counts->allocations,
+               counts->bytes_requested, counts->realloc_copy_bytes, counts->peak_live_bytes);
+        allocations += counts->allocations;
+        bytes_requested += counts->bytes_requested;
+        realloc_copy_bytes += counts->realloc_copy_bytes;
+    }
+    printf("%-13s %8ld %12ld %12ld %12ld\n", "Total", allocations, bytes_requested, realloc_copy_bytes,
+           report->peak_live_bytes);
+}
@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "cost_model.h"
+#include "utilities.h"
+#include "opcode_table.h"
+#include "error_handling.h"
+
+/**
+ * Returns the number of data memory accesses needed to reach an operand once.
+ * Direct and register indirect operands live in memory; immediates and registers do not.
+ * @param mode The addressing mode of the operand.
+ * @return 1 for memory operands, 0 otherwise.
+ */
+static int operand_accesses(int mode) {
+    return (mode == 1 || mode == 2) ? 1 : 0;
+}
+
+/**
+ * Estimates the static cost of an instruction from its word count and the memory accesses
+ * implied by its effects in the instruction set description and its addressing modes.
+ * Jump targets and lea's source are addresses, not data, so they are never read.
+ * @param operation The operation part of the instruction.
+ * @param operands The operands part of the instruction.
+ * @return The estimated cost; words is -1 if the instruction is invalid.
+ */
+InstructionCost get_instruction_cost(const char *operation, const char *operands) {
+    InstructionCost cost = {-1, 0, 0};
+    int opcode = get_opcode(operation);
+    if (opcode == -1) return cost;
+
+    cost.words = get_instruction_length(operation, operands);
+    if (cost.words == -1) return cost;
+
+    char source[MAX_LINE_LENGTH + 1];
+    char target[MAX_LINE_LENGTH + 1];
+    split_operands(operands, source, target);
+    int source_mode = get_addressing_mode(source);
+    int target_mode = get_addressing_mode(target);
+
+    int effects = get_opcode_entry(opcode)->effects;
+    if (effects & EFFECT_READS_SOURCE) cost.memory_accesses += operand_accesses(source_mode);
+    if (effects & EFFECT_READS_TARGET) cost.memory_accesses += operand_accesses(target_mode);
+    if (effects & EFFECT_WRITES_TARGET) cost.memory_accesses += operand_accesses(target_mode);
+    /* jsr pushes and rts pops the return address */
+    if (effects & EFFECT_USES_STACK) cost.memory_accesses++;
+
+    cost.cycles = cost.words + cost.memory_accesses;
+    return cost;
+}
+
+/**
+ * Initializes the cost report with default values and allocates initial memory.
+ * @param report Pointer to the cost report to initialize.
+ */
+void init_cost_report(CostReport *report) {
+    report->count = 0;
+    report->capacity = 10;
+    report->entries = malloc(sizeof(LabelCost) * report->capacity);
+}
+
+/**
+ * Adds the cost of one line to the report. A labeled line starts a new entry; unlabeled lines
+ * are charged to the most recent label, or to "(start)" before the first label.
+ * @param report Pointer to the cost report.
+ * @param label The label defined on the line, or an empty string.
+ * @param code_words The number of instruction words the line emits.
+ * @param data_words The number of data words the line emits.
+ * @param cycles The estimated cycles of the line.
+ */
+void add_line_cost(CostReport *report, const char *label, int code_words, int data_words, int cycles) {
+    if (report->entries == NULL) return;
+
+    if (label[0] != '\0' || report->count == 0) {
+        /* Resize the report if necessary */
+        if (report->count == report->capacity) {
+            LabelCost *new_entries = realloc(report->entries, sizeof(LabelCost) * report->capacity * 2);
+            if (new_entries == NULL) {
+                log_error(ERR_MEMORY, "Failed to resize cost report", "cost_model", -1);
+                return;
+            }
+            report->entries = new_entries;
+            report->capacity *= 2;
+        }
+        LabelCost *entry = &report->entries[report->count++];
+        strncpy(entry->label, label[0] != '\0' ? label : "(start)", MAX_LABEL_LENGTH);
+        entry->label[MAX_LABEL_LENGTH] = '\0';
+        entry->code_words = 0;
+        entry->data_words = 0;
+        entry->cycles = 0;
+    }
+
+    LabelCost *current = &report->entries[report->count - 1];
+    current->code_words += code_words;
+    current->data_words += data_words;
+    current->cycles += cycles;
+}
+
+/**
+ * Prints the cost report as a table with one row per label and a total row.
+ * @param report Pointer to the cost report.
+ * @param filename The name of the file the report belongs to.
+ */
+void print_cost_report(const CostReport *report, const char *filename) {
+    int code_words = 0, data_words = 0, cycles = 0;
+
+    printf("Cost report for file: %s\n", filename);
+    printf("%-31s %6s %6s %7s\n", "Label", "Code", "Data", "Cycles");
+    for (int i = 0; i < report->count; i++) {
+        const LabelCost *entry = &report->entries[i];
+        printf("%-31s %6d %6d %7d\n", entry->label, entry->code_words, entry->data_words, entry->cycles);
+        code_words += entry->code_words;
+        data_words += entry->data_words;
+        cycles += entry->cycles;
+    }
+    printf("%-31s %6d %6d %7d\n", "Total", code_words, data_words, cycles);
+}
+
+/**
+ * Frees the memory allocated for the cost report.
+ * @param report Pointer to the cost report to free.
+ */
+void free_cost_report(CostReport *report) {
+    free(report->entries);
+    report->entries = NULL;
+    report->count = 0;
+    report->capacity = 0;
+}
@@ -0,0 +1,363 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "disassembler.h"
+#include "opcode_table.h"
+#include "error_handling.h"
+
+#define WORD_MASK 0x7FFF
+#define MAX_DATA_VALUES 5  /* Values per .data line, so the line stays under MAX_LINE_LENGTH */
+#define MAX_STRING_RUN 30  /* Characters per .string line, for the same reason */
+
+/**
+ * Decodes the first word of an instruction by looking it up in the decode table,
+ * which is generated at build time from the instruction set description.
+ * @param word The 15-bit first word.
+ * @return The decoded fields; opcode is -1 if the word is not a valid first word.
+ */
+DecodedWord decode_first_word(unsigned int word) {
+    return decode_table[word & WORD_MASK];
+}
+
+/**
+ * Loads the symbols of an .ent or .ext file into the image. The files are optional,
+ * so a missing file is not an error.
+ * @param image Pointer to the image.
+ * @param base_name The base name of the file (without extension).
+ * @param extension The extension of the file, ".ent" or ".ext".
+ * @param is_entry True for entries (label at the address), false for externals (reference at the address).
+ */
+static void load_symbol_file(ObjectImage *image, const char *base_name, const char *extension, bool is_entry) {
+    char filename[MEMORY_SIZE];
+    snprintf(filename, sizeof(filename), "%s%s", base_name, extension);
+    FILE *file = fopen(filename, "r");
+    if (!file) return;
+
+    char name[MAX_LABEL_LENGTH + 1];
+    int address;
+    while (fscanf(file, "%31s %d", name, &address) == 2) {
+        if (address < FIRST_ADDRESS || address >= MEMORY_SIZE) {
+            log_error(ERR_SYNTAX, "Symbol address out of range", filename, -1);
+            continue;
+        }
+        if (is_entry) {
+            strcpy(image->labels[address], name);
+            image->entries[address] = true;
+        } else {
+            strcpy(image->externals[address], name);
+        }
+    }
+    fclose(file);
+}
+
+/**
+ * Loads an object image from <base_name>.ob, together with its .ent and .ext files when present.
+ * @param base_name The base name of the files (without extension).
+ * @return Pointer to the loaded image, or NULL on error.
+ */
+ObjectImage *load_object_image(const char *base_name) {
+    char filename[MEMORY_SIZE];
+    snprintf(filename, sizeof(filename), "%s.ob", base_name);
+    FILE *file = fopen(filename, "r");
+    if (!file) {
+        log_error(ERR_FILE_INPUT, "Cannot open object file", filename, -1);
+        return NULL;
+    }
+
+    ObjectImage *image = calloc(1, sizeof(ObjectImage));
+    if (!image) {
+        log_error(ERR_MEMORY, "Failed to allocate memory for object image", filename, -1);
+        fclose(file);
+        return NULL;
+    }
+
+    /* The header holds the code and data lengths in words */
+    if (fscanf(file, "%d %d", &image->code_length, &image->data_length) != 2 ||
+        image->code_length < 0 || image->data_length < 0 ||
+        FIRST_ADDRESS + image->code_length + image->data_length > MEMORY_SIZE) {
+        log_error(ERR_SYNTAX, "Invalid object file header", filename, -1);
+        fclose(file);
+        free(image);
+        return NULL;
+    }
+
+    int address;
+    unsigned int word;
+    while (fscanf(file, "%d %o", &address, &word) == 2) {
+        if (address < FIRST_ADDRESS || address >= MEMORY_SIZE) {
+            log_error(ERR_SYNTAX, "Word address out of range", filename, -1);
+            fclose(file);
+            free(image);
+            return NULL;
+        }
+        image->words[address] = word & WORD_MASK;
+    }
+    fclose(file);
+
+    load_symbol_file(image, base_name, ".ent", true);
+    load_symbol_file(image, base_name, ".ext", false);
+    return image;
+}
+
+/**
+ * Frees an object image.
+ * @param image Pointer to the image to free.
+ */
+void free_object_image(ObjectImage *image) {
+    free(image);
+}
+
+/**
+ * Returns the address of the word holding an instruction's source or target operand.
+ * @param decoded The decoded first word.
+ * @param address The address of the first word.
+ * @param is_source True for the source operand, false for the target.
+ * @return The address of the operand word.
+ */
+static int operand_address(DecodedWord decoded, int address, bool is_source) {
+    if (is_source || decoded.length == 2) {
+        return address + 1;
+    }
+    return address + (decoded.source_mode != 4 ? 2 : 1);
+}
+
+/**
+ * Decodes the instruction at an address, treating it as invalid if it runs past the code section.
+ * @param image Pointer to the image.
+ * @param address The address of the first word.
+ * @return The decoded fields; opcode is -1 if there is no valid instruction at the address.
+ */
+static DecodedWord decode_at(const ObjectImage *image, int address) {
+    DecodedWord decoded = decode_first_word(image->words[address]);
+    if (address + decoded.length > FIRST_ADDRESS + image->code_length) {
+        decoded.opcode = -1;
+        decoded.length = 1;
+    }
+    return decoded;
+}
+
+/**
+ * Names the labels and externals the code refers to but the .ent and .ext files did not:
+ * every relocatable operand gets a label "L<address>" at its target, and every unnamed
+ * external reference gets an external "X<address>".
+ * @param image Pointer to the image.
+ */
+static void reconstruct_labels(ObjectImage *image) {
+    int code_end = FIRST_ADDRESS + image->code_length;
+    int image_end = code_end + image->data_length;
+    int address = FIRST_ADDRESS;
+    while (address < code_end) {
+        DecodedWord decoded = decode_at(image, address);
+        for (int i = 0; i < 2 && decoded.opcode != -1; i++) {
+            bool is_source = (i == 0);
+            int mode = is_source ? decoded.source_mode : decoded.target_mode;
+            if (mode != 1) continue;
+
+            int word_address = operand_address(decoded, address, is_source);
+            unsigned int word = image->words[word_address];
+            if ((word & 0x7) == 1) {
+                if (image->externals[word_address][0] == '\0') {
+                    snprintf(image->externals[word_address], MAX_LABEL_LENGTH + 1, "X%04d", word_address);
+                }
+            } else {
+                int target = (word >> 3) & 0xFFF;
+                if (target >= FIRST_ADDRESS && target < image_end && image->labels[target][0] == '\0') {
+                    snprintf(image->labels[target], MAX_LABEL_LENGTH + 1, "L%04d", target);
+                }
+            }
+        }
+        address += decoded.length;
+    }
+}
+
+/**
+ * Formats one operand of an instruction as assembly text.
+ * @param image Pointer to the image.
+ * @param mode The addressing mode of the operand.
+ * @param word_address The address of the operand word.
+ * @param is_source True for the source operand, false for the target.
+ * @param text Buffer of at least MAX_LABEL_LENGTH + 1 characters for the result.
+ */
+static void format_operand(const ObjectImage *image, int mode, int word_address, bool is_source, char *text) {
+    unsigned int word = image->words[word_address];
+    int size = MAX_LABEL_LENGTH + 1;
+    switch (mode) {
+        case 0: {
+            /* Immediate: 12-bit two's complement value above the A.R.E. field */
+            int value = (word >> 3) & 0xFFF;
+            if (value & 0x800) value -= 0x1000;
+            snprintf(text, size, "#%d", value);
+            break;
+        }
+        case 1:
+            if ((word & 0x7) == 1) {
+                snprintf(text, size, "%s", image->externals[word_address]);
+            } else {
+                int target = (word >> 3) & 0xFFF;
+                if (target < MEMORY_SIZE && image->labels[target][0] != '\0') {
+                    snprintf(text, size, "%s", image->labels[target]);
+                } else {
+                    snprintf(text, size, "L%04d", target);
+                }
+            }
+            break;
+        case 2:
+            snprintf(text, size, "*r%u", is_source ? (word >> 6) & 0x7 : (word >> 3) & 0x7);
+            break;
+        default:
+            snprintf(text, size, "r%u", is_source ? (word >> 6) & 0x7 : (word >> 3) & 0x7);
+            break;
+    }
+}
+
+/**
+ * Writes the label of an address followed by a tab, or just a tab if there is no label.
+ * @param image Pointer to the image.
+ * @param address The address of the line.
+ * @param output The file to write to.
+ */
+static void write_label(const ObjectImage *image, int address, FILE *output) {
+    if (image->labels[address][0] != '\0') {
+        fprintf(output, "%s:", image->labels[address]);
+    }
+    fputc('\t', output);
+}
+
+/**
+ * Checks if a data word can be written inside a .string literal and read back unchanged.
+ * Quotes end the literal, ';' starts a comment, and the assembler collapses whitespace
+ * and drops spaces next to commas, so spaces are only kept between two other characters.
+ * @param image Pointer to the image.
+ * @param address The address of the word.
+ * @param first The address of the first character of the literal.
+ * @return true if the word can be part of the literal, false otherwise.
+ */
+static bool is_string_char(const ObjectImage *image, int address, int first) {
+    unsigned int c = image->words[address];
+    if (c == ' ') {
+        if (address + 1 >= MEMORY_SIZE) return false;
+        unsigned int next = image->words[address + 1];
+        unsigned int previous = image->words[address - 1];
+        return address > first && next > ' ' && next <= '~' && next != ',' &&
+               previous != ' ' && previous != ',';
+    }
+    return c > ' ' && c <= '~' && c != '"' && c != ';';
+}
+
+/**
+ * Returns the number of characters of a zero-terminated string starting at an address,
+ * if the words there can be written back as a .string directive.
+ * @param image Pointer to the image.
+ * @param address The address of the first character.
+ * @param end The end of the data section.
+ * @return The number of characters (excluding the terminator), or 0 if there is no such string.
+ */
+static int string_run_length(const ObjectImage *image, int address, int end) {
+    int length = 0;
+    while (address + length < end && length < MAX_STRING_RUN &&
+           (length == 0 || image->labels[address + length][0] == '\0') &&
+           is_string_char(image, address + length, address)) {
+        length++;
+    }
+    int terminator = address + length;
+    if (length == 0 || terminator >= end || image->words[terminator] != 0 ||
+        image->labels[terminator][0] != '\0') {
+        return 0;
+    }
+    return length;
+}
+
+/**
+ * Writes the data section as .string directives where the words form printable strings
+ * and as .data directives otherwise. A new directive starts at every label.
+ * @param image Pointer to the image.
+ * @param output The file to write to.
+ */
+static void write_data_section(const ObjectImage *image, FILE *output) {
+    int address = FIRST_ADDRESS + image->code_length;
+    int end = address + image->data_length;
+    while (address < end) {
+        write_label(image, address, output);
+        int length = string_run_length(image, address, end);
+        if (length > 0) {
+            fprintf(output, ".string\t\"");
+            for (int i = 0; i < length; i++) {
+                fputc((int)image->words[address + i], output);
+            }
+            fprintf(output, "\"\n");
+            address += length + 1;
+            continue;
+        }
+
+        fprintf(output, ".data\t");
+        int count = 0;
+        do {
+            /* Data words are 15-bit two's complement values */
+            int value = image->words[address];
+            if (value & 0x4000) value -= 0x8000;
+            fprintf(output, count == 0 ? "%d" : ", %d", value);
+            count++;
+            address++;
+        } while (address < end && count < MAX_DATA_VALUES && image->labels[address][0] == '\0' &&
+                 string_run_length(image, address, end) == 0);
+        fputc('\n', output);
+    }
+}
+
+/**
+ * Writes an object image as assembly source: .extern and .entry declarations first, then one
+ * line per instruction and the data section. Words in the code section that are not valid
+ * instructions are written as .data with a comment.
+ * @param image Pointer to the image; labels and externals it is missing are added to it.
+ * @param output The file to write the assembly text to.
+ */
+void disassemble_image(ObjectImage *image, FILE *output) {
+    int code_end = FIRST_ADDRESS + image->code_length;
+    int image_end = code_end + image->data_length;
+
+    reconstruct_labels(image);
+
+    /* Declare each external once */
+    for (int address = FIRST_ADDRESS; address < code_end; address++) {
+        if (image->externals[address][0] == '\0') continue;
+        bool declared = false;
+        for (int earlier = FIRST_ADDRESS; earlier < address && !declared; earlier++) {
+            declared = strcmp(image->externals[earlier], image->externals[address]) == 0;
+        }
+        if (!declared) {
+            fprintf(output, ".extern %s\n", image->externals[address]);
+        }
+    }
+    for (int address = FIRST_ADDRESS; address < image_end; address++) {
+        if (image->entries[address]) {
+            fprintf(output, ".entry %s\n", image->labels[address]);
+        }
+    }
+
+    int address = FIRST_ADDRESS;
+    while (address < code_end) {
+        DecodedWord decoded = decode_at(image, address);
+        write_label(image, address, output);
+        if (decoded.opcode == -1) {
+            fprintf(output, ".data\t%u ; not a valid instruction\n", image->words[address]);
+            address++;
+            continue;
+        }
+
+        char source[MAX_LABEL_LENGTH + 1];
+        char target[MAX_LABEL_LENGTH + 1];
+        fprintf(output, "%s", get_mnemonic(decoded.opcode));
+        if (decoded.source_mode != 4) {
+            format_operand(image, decoded.source_mode, operand_address(decoded, address, true), true, source);
+            fprintf(output, "\t%s,", source);
+        }
+        if (decoded.target_mode != 4) {
+            format_operand(image, decoded.target_mode, operand_address(decoded, address, false), false, target);
+            fprintf(output, decoded.source_mode != 4 ? " %s" : "\t%s", target);
+        }
+        fputc('\n', output);
+        address += decoded.length;
+    }
+
+    write_data_section(image, output);
+}
@@ -0,0 +1,59 @@
+/**
+ * Disassembler
+ *
+ * Purpose:
+ * Turns object files produced by the assembler back into assembly source.
+ *
+ * Usage: ./disassembler <input_file1> [input_file2] ...
+ *
+ * Each argument is a base name without extension. The disassembler reads
+ * <name>.ob, and <name>.ent and <name>.ext when they exist, and writes
+ * <name>_dis.as, which the assembler turns back into the same words.
+ *
+ * Labels are reconstructed from the entry file, the external file and the
+ * targets of relocatable operands (named L<address>). External references
+ * missing from the .ext file are named X<address>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "disassembler.h"
+#include "error_handling.h"
+
+#define MAX_FILENAME 100
+
+int main(int argc, char *argv[]) {
+    /* Check if at least one input file was provided */
+    if (argc < 2) {
+        log_error(ERR_FILE_INPUT, "No input files provided", "main", -1);
+        print_error_summary();
+        return 1;
+    }
+    int valid_files = 0;
+    /* Process each input file */
+    for (int i = 1; i < argc; i++) {
+        char output_filename[MAX_FILENAME];
+
+        ObjectImage *image = load_object_image(argv[i]);
+        if (!image) {
+            continue;  /* Skip to the next file if it can't be loaded */
+        }
+        valid_files++;
+
+        snprintf(output_filename, sizeof(output_filename), "%s_dis.as", argv[i]);
+        FILE *output = fopen(output_filename, "w");
+        if (!output) {
+            log_error(ERR_FILE_OUTPUT, "Failed to create disassembly file", output_filename, -1);
+            free_object_image(image);
+            continue;
+        }
+        disassemble_image(image, output);
+        fclose(output);
+        free_object_image(image);
+        printf("Disassembly done for file: %s.ob\n", argv[i]);
+    }
+
+    /* Print a summary of all errors encountered during disassembly */
+    print_error_summary();
+    return valid_files == 0 ? 1 : 0;
+}
@@ -1,6 +1,7 @@
 #include "error_handling.h"
 #include <stdlib.h>
 #include <string.h>
+#include "alloc_stats.h"
 
 #define MAX_ERRORS 100 
 
@@ -25,7 +26,7 @@ void log_error(ErrorCategory category, const char *specific_message, const char
         /* Allocate memory for the error description
          * The +50 is to account for the additional formatting characters
          * and potential line number length */
-        char *description = malloc(strlen(specific_message) + strlen(filename) + 50);
+        char *description = counted_malloc(strlen(specific_message) + strlen(filename) + 50);
         if (description == NULL) {
             /* If malloc fails, print an error message and return */
             fprintf(stderr, "Failed to allocate memory for error description\n");
@@ -69,6 +70,6 @@ void print_error_summary() {
 
     /* Free the allocated memory for error descriptions */
     for (int i = 0; i < error_count; i++) {
-        free((void*)error_log[i].description);
+        counted_free((void*)error_log[i].description);
     }
 }
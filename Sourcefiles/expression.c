@@ -0,0 +1,117 @@
+#include <ctype.h>
+#include <string.h>
+#include "expression.h"
+
+/**
+ * Checks if an operand or data value is an expression. A leading sign belongs to a number.
+ * @param text The text to check, without a leading '#'.
+ * @return true if the text contains an operator after its first character, false otherwise.
+ */
+bool is_expression(const char *text) {
+    return text[0] != '\0' && strpbrk(text + 1, "+-*") != NULL;
+}
+
+/**
+ * Parses a term: an optionally signed number or label.
+ * @param cursor Pointer to the current position; advanced past the term.
+ * @param symbol_table Pointer to the symbol table.
+ * @param result Set to the value of the term.
+ * @return true if a term was parsed, false otherwise.
+ */
+static bool parse_term(const char **cursor, SymbolTable *symbol_table, ExpressionValue *result) {
+    int sign = 1;
+    if (**cursor == '+' || **cursor == '-') {
+        sign = **cursor == '-' ? -1 : 1;
+        (*cursor)++;
+    }
+
+    if (isdigit((unsigned char)**cursor)) {
+        result->value = 0;
+        while (isdigit((unsigned char)**cursor)) {
+            result->value = result->value * 10 + (**cursor - '0');
+            (*cursor)++;
+        }
+        result->relocations = 0;
+    } else if (isalpha((unsigned char)**cursor)) {
+        char name[MAX_LABEL_LENGTH + 1];
+        int length = 0;
+        while (isalnum((unsigned char)**cursor)) {
+            if (length == MAX_LABEL_LENGTH) return false;
+            name[length++] = **cursor;
+            (*cursor)++;
+        }
+        name[length] = '\0';
+
+        /* External addresses are only known to the linker, so they cannot be folded */
+        Symbol *symbol = find_symbol(symbol_table, name);
+        if (!symbol || symbol->type == SYMBOL_TYPE_EXTERNAL) return false;
+        result->value = symbol->address;
+        result->relocations = 1;
+    } else {
+        return false;
+    }
+
+    result->value *= sign;
+    result->relocations *= sign;
+    return true;
+}
+
+/**
+ * Parses a product of terms.
+ * @param cursor Pointer to the current position; advanced past the product.
+ * @param symbol_table Pointer to the symbol table.
+ * @param result Set to the value of the product.
+ * @return true if a product was parsed, false otherwise.
+ */
+static bool parse_product(const char **cursor, SymbolTable *symbol_table, ExpressionValue *result) {
+    if (!parse_term(cursor, symbol_table, result)) return false;
+    while (**cursor == '*') {
+        ExpressionValue factor;
+        (*cursor)++;
+        if (!parse_term(cursor, symbol_table, &factor)) return false;
+        /* A scaled address is no longer an address; only one side may hold labels */
+        if (result->relocations != 0 && factor.relocations != 0) {
+            result->relocations = 2;
+        } else {
+            result->relocations = result->relocations * factor.value + factor.relocations * result->value;
+        }
+        result->value *= factor.value;
+    }
+    return true;
+}
+
+/**
+ * Parses a sum of products.
+ * @param cursor Pointer to the current position; advanced past the sum.
+ * @param symbol_table Pointer to the symbol table.
+ * @param result Set to the value of the sum.
+ * @return true if a sum was parsed, false otherwise.
+ */
+static bool parse_sum(const char **cursor, SymbolTable *symbol_table, ExpressionValue *result) {
+    if (!parse_product(cursor, symbol_table, result)) return false;
+    while (**cursor == '+' || **cursor == '-') {
+        ExpressionValue term;
+        int sign = **cursor == '-' ? -1 : 1;
+        (*cursor)++;
+        if (!parse_product(cursor, symbol_table, &term)) return false;
+        result->value += sign * term.value;
+        result->relocations += sign * term.relocations;
+    }
+    return true;
+}
+
+/**
+ * Evaluates a constant expression at assembly time. Labels are looked up in the symbol
+ * table, so in the second pass forward references are already resolved.
+ * @param text The expression, without a leading '#'.
+ * @param symbol_table Pointer to the symbol table.
+ * @param result Set to the folded value if the expression is valid.
+ * @return true if the whole text was a valid expression, false otherwise.
+ */
+bool evaluate_expression(const char *text, SymbolTable *symbol_table, ExpressionValue *result) {
+    const char *cursor = text;
+    while (isspace((unsigned char)*cursor)) cursor++;
+    if (!parse_sum(&cursor, symbol_table, result)) return false;
+    while (isspace((unsigned char)*cursor)) cursor++;
+    return *cursor == '\0';
+}
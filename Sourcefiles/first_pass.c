@@ -8,6 +8,10 @@
 #include "symbol_table.h"
 #include "pre_assembler.h"
 #include "error_handling.h"
+#include "cost_model.h"
+#include "options.h"
+#include "optimizer.h"
+#include "time_report.h"
 
 /**
  * Performs the first pass of the assembler. It reads the input file line by line, processes labels,
@@ -15,7 +19,7 @@
  * data counters (IC and DC).
  * @param filename The name of the input file to process.
  * @param symbol_table Pointer to the symbol table to be populated during the first pass.
- * @return true if the first pass was successful, false if errors were encountered.
+ * @return true if the first pass and the second pass it runs were successful, false if errors were encountered.
  */
 bool first_pass(const char *filename, SymbolTable *symbol_table) {
     /* Initialize instruction counter (IC) and data counter (DC) */
@@ -34,6 +38,10 @@ bool first_pass(const char *filename, SymbolTable *symbol_table) {
     char operands[MAX_LINE_LENGTH + 1];
     int line_number = 0;
     bool error_found = false;
+    CostReport cost_report = {0};
+    if (assembler_options.cost_report) {
+        init_cost_report(&cost_report);
+    }
 
     /* Process each line of the input file */
     while (fgets(line, sizeof(line), file)) {
@@ -96,6 +104,9 @@ bool first_pass(const char *filename, SymbolTable *symbol_table) {
                     error_found = true;
                 } else {
                     DC += data_count;
+                    if (assembler_options.cost_report) {
+                        add_line_cost(&cost_report, label, 0, data_count, 0);
+                    }
                 }
             } else if (strcmp(operation, ".string") == 0) {
                 /* Handle .string directive */
@@ -109,6 +120,9 @@ bool first_pass(const char *filename, SymbolTable *symbol_table) {
                     error_found = true;
                 } else {
                     DC += strlen(operands) - 2 + 1;  /* Length of string + null terminator - quotes */
+                    if (assembler_options.cost_report) {
+                        add_line_cost(&cost_report, label, 0, strlen(operands) - 2 + 1, 0);
+                    }
                 }
             } else if (strcmp(operation, ".entry") == 0) {
                 /* Mark that the file has entry points */
@@ -134,16 +148,28 @@ bool first_pass(const char *filename, SymbolTable *symbol_table) {
             }
         } else if (get_opcode(operation) != -1) {
             /* Process instructions */
+            char source[MAX_LINE_LENGTH + 1];
+            char target[MAX_LINE_LENGTH + 1];
             int inst_length = get_instruction_length(operation, operands);
-            if (inst_length == -1) {
+            if (!split_operands(operands, source, target)) {
+                log_error(ERR_SYNTAX, "Operand too long", filename, line_number);
+                error_found = true;
+            } else if (inst_length == -1) {
                 log_error(ERR_SYNTAX, "Invalid instruction format", filename, line_number);
                 error_found = true;
+            } else if (!is_legal_addressing(operation, operands)) {
+                log_error(ERR_SYNTAX, "Illegal addressing mode for instruction", filename, line_number);
+                error_found = true;
             } else {
                 if (label[0] != '\0') {
                     if (!add_symbol(symbol_table, label, IC, SYMBOL_TYPE_CODE, filename, line_number)) {
                         error_found = true;
                     }
                 }
+                if (assembler_options.cost_report) {
+                    InstructionCost cost = get_instruction_cost(operation, operands);
+                    add_line_cost(&cost_report, label, cost.words, 0, cost.cycles);
+                }
                 IC += inst_length; /* Updating IC */
             }
         } else {
@@ -162,10 +188,27 @@ bool first_pass(const char *filename, SymbolTable *symbol_table) {
         }
     }
 
+    /* With -O1 or --pool-data, rewrite and redo the first pass until the file stops changing */
+    if (!error_found && ((assembler_options.optimize && optimize_code(filename, symbol_table)) ||
+                         (assembler_options.pool_data && pool_data_blocks(filename)))) {
+        free_cost_report(&cost_report);
+        free_symbol_table(symbol_table);
+        free_external_table(&symbol_table->external_table);
+        init_symbol_table(symbol_table);
+        return first_pass(filename, symbol_table);
+    }
+
     /* Perform second pass if no errors were found in the first pass */
+    bool second_pass_done = false;
     if (!error_found) {
-        second_pass(filename, symbol_table, IC, DC);
+        start_phase(PHASE_SECOND_PASS);
+        second_pass_done = second_pass(filename, symbol_table, IC, DC);
+        end_phase();
+        if (second_pass_done && assembler_options.cost_report) {
+            print_cost_report(&cost_report, filename);
+        }
     }
+    free_cost_report(&cost_report);
 
-    return !error_found;
+    return !error_found && second_pass_done;
 }
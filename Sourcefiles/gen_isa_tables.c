@@ -0,0 +1,304 @@
+/**
+ * ISA Table Generator
+ *
+ * Purpose:
+ * Runs at build time and compiles the instruction set description into
+ * isa_tables.c. Everything the assembler and disassembler know about the
+ * instruction set comes from that one file:
+ * - The opcode table (mnemonic, opcode, operand count, legal addressing modes,
+ *   and the effects used by the cost model and the optimizer).
+ * - A perfect hash over the mnemonics, used by get_opcode().
+ * - The first word and legality flag of every opcode and addressing mode
+ *   combination, used by the first pass and write_instruction().
+ * - The decoded fields of every possible 15-bit first word, used by the
+ *   disassembler.
+ * A variant instruction set only needs a different description file.
+ *
+ * Usage: ./gen_isa_tables <description_file> > isa_tables.c
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include "isa_tables.h"
+
+#define MAX_LINE_LENGTH 80
+#define MAX_SEED 1000000
+
+static OpcodeEntry entries[OPCODE_COUNT];
+
+/**
+ * Parses an addressing mode field of the description: a list of mode digits, or '-'.
+ * @param field The field to parse.
+ * @return The bitmask of the listed modes, NO_OPERAND for '-', or -1 if the field is invalid.
+ */
+static int parse_modes(const char *field) {
+    if (strcmp(field, "-") == 0) {
+        return NO_OPERAND;
+    }
+    int modes = 0;
+    for (const char *p = field; *p != '\0'; p++) {
+        if (*p < '0' || *p > '3') return -1;
+        modes |= MODE_BIT(*p - '0');
+    }
+    return modes;
+}
+
+/**
+ * Parses the effects field of the description: a list of effect letters, or '-'.
+ * @param field The field to parse.
+ * @return The bitmask of EFFECT_* flags, or -1 if the field is invalid.
+ */
+static int parse_effects(const char *field) {
+    if (strcmp(field, "-") == 0) {
+        return 0;
+    }
+    int effects = 0;
+    for (const char *p = field; *p != '\0'; p++) {
+        switch (*p) {
+            case 'S': effects |= EFFECT_READS_SOURCE; break;
+            case 'T': effects |= EFFECT_READS_TARGET; break;
+            case 'W': effects |= EFFECT_WRITES_TARGET; break;
+            case 'P': effects |= EFFECT_USES_STACK; break;
+            case 'E': effects |= EFFECT_ENDS_FLOW; break;
+            default: return -1;
+        }
+    }
+    return effects;
+}
+
+/**
+ * Reads the description file into the entries array.
+ * @param filename The name of the description file.
+ * @return true if the file was read successfully, false otherwise.
+ */
+static bool read_description(const char *filename) {
+    FILE *file = fopen(filename, "r");
+    if (!file) {
+        fprintf(stderr, "gen_isa_tables: cannot open %s\n", filename);
+        return false;
+    }
+
+    char line[MAX_LINE_LENGTH + 1];
+    int line_number = 0;
+    bool ok = true;
+    while (fgets(line, sizeof(line), file)) {
+        line_number++;
+        char mnemonic[MAX_LINE_LENGTH + 1], source[MAX_LINE_LENGTH + 1], target[MAX_LINE_LENGTH + 1];
+        char effects[MAX_LINE_LENGTH + 1];
+        int opcode;
+        char *comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+        if (sscanf(line, "%s", mnemonic) != 1) continue;  /* Skip empty lines */
+
+        if (sscanf(line, "%s %d %s %s %s", mnemonic, &opcode, source, target, effects) != 5 ||
+            strlen(mnemonic) >= sizeof(entries[0].mnemonic) || opcode < 0 || opcode >= OPCODE_COUNT ||
+            parse_modes(source) == -1 || parse_modes(target) == -1 || parse_effects(effects) == -1) {
+            fprintf(stderr, "gen_isa_tables: %s:%d: invalid instruction description\n", filename, line_number);
+            ok = false;
+            continue;
+        }
+        if (entries[opcode].mnemonic[0] != '\0') {
+            fprintf(stderr, "gen_isa_tables: %s:%d: opcode %d is defined twice\n", filename, line_number, opcode);
+            ok = false;
+            continue;
+        }
+
+        OpcodeEntry *entry = &entries[opcode];
+        strcpy(entry->mnemonic, mnemonic);
+        entry->opcode = opcode;
+        entry->source_modes = parse_modes(source);
+        entry->target_modes = parse_modes(target);
+        entry->effects = parse_effects(effects);
+        entry->operands = (entry->source_modes != NO_OPERAND) + (entry->target_modes != NO_OPERAND);
+        /* A single operand is always encoded as the target */
+        if (entry->operands == 1 && entry->target_modes == NO_OPERAND) {
+            fprintf(stderr, "gen_isa_tables: %s:%d: a single operand must be the target\n", filename, line_number);
+            ok = false;
+        }
+        if (((entry->effects & EFFECT_READS_SOURCE) && entry->source_modes == NO_OPERAND) ||
+            ((entry->effects & (EFFECT_READS_TARGET | EFFECT_WRITES_TARGET)) && entry->target_modes == NO_OPERAND)) {
+            fprintf(stderr, "gen_isa_tables: %s:%d: an effect names a missing operand\n", filename, line_number);
+            ok = false;
+        }
+    }
+    fclose(file);
+    return ok;
+}
+
+/**
+ * Builds the first word of an instruction: the opcode from bit 11, one bit per
+ * addressing mode starting at bit 7 for the source and bit 3 for the target, and
+ * an absolute A.R.E. field.
+ * @param opcode The opcode.
+ * @param source_mode The source addressing mode, or 4 if there is no source.
+ * @param target_mode The target addressing mode, or 4 if there is no target.
+ * @return The 15-bit first word.
+ */
+static unsigned int build_first_word(int opcode, int source_mode, int target_mode) {
+    unsigned int first_word = (opcode & 0xF) << 11;
+    if (source_mode != 4) {
+        first_word |= 1 << (7 + source_mode);
+    }
+    if (target_mode != 4) {
+        first_word |= 1 << (3 + target_mode);
+    }
+    return (first_word | 4) & 0x7FFF;
+}
+
+/**
+ * Checks if an opcode allows a combination of addressing modes.
+ * @param opcode The opcode.
+ * @param source_mode The source addressing mode, or 4 if there is no source.
+ * @param target_mode The target addressing mode, or 4 if there is no target.
+ * @return true if the combination is legal, false otherwise.
+ */
+static bool is_legal(int opcode, int source_mode, int target_mode) {
+    return (entries[opcode].source_modes & MODE_BIT(source_mode)) &&
+           (entries[opcode].target_modes & MODE_BIT(target_mode));
+}
+
+/**
+ * Converts a one-hot addressing mode field of a first word to its addressing mode.
+ * @param bits The 4-bit field.
+ * @return The addressing mode (0-3), 4 if no bit is set, or -1 if more than one bit is set.
+ */
+static int mode_from_bits(unsigned int bits) {
+    switch (bits) {
+        case 0: return 4;
+        case 1: return 0;
+        case 2: return 1;
+        case 4: return 2;
+        case 8: return 3;
+        default: return -1;
+    }
+}
+
+/**
+ * Searches for a seed under which every mnemonic hashes to its own slot.
+ * @param seed Set to the seed found.
+ * @return true if a seed was found, false otherwise.
+ */
+static bool find_hash_seed(unsigned int *seed) {
+    for (unsigned int candidate = 0; candidate < MAX_SEED; candidate++) {
+        bool used[MNEMONIC_HASH_SIZE] = {false};
+        bool collision = false;
+        for (int opcode = 0; opcode < OPCODE_COUNT && !collision; opcode++) {
+            if (entries[opcode].mnemonic[0] == '\0') continue;
+            unsigned int slot = hash_mnemonic(entries[opcode].mnemonic, candidate);
+            collision = used[slot];
+            used[slot] = true;
+        }
+        if (!collision) {
+            *seed = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Writes the opcode table, indexed by opcode.
+ */
+static void write_opcode_table(void) {
+    printf("const OpcodeEntry opcode_table[OPCODE_COUNT] = {\n");
+    for (int opcode = 0; opcode < OPCODE_COUNT; opcode++) {
+        const OpcodeEntry *entry = &entries[opcode];
+        printf("    {\"%s\", %d, %d, 0x%02x, 0x%02x, 0x%02x}%s\n", entry->mnemonic, opcode,
+               entry->mnemonic[0] != '\0' ? entry->operands : -1, entry->source_modes, entry->target_modes,
+               entry->effects, opcode < OPCODE_COUNT - 1 ? "," : "");
+    }
+    printf("};\n\n");
+}
+
+/**
+ * Writes the hash seed and the slot table of the mnemonic perfect hash.
+ * @param seed The collision-free seed.
+ */
+static void write_mnemonic_hash(unsigned int seed) {
+    signed char slots[MNEMONIC_HASH_SIZE];
+    memset(slots, -1, sizeof(slots));
+    for (int opcode = 0; opcode < OPCODE_COUNT; opcode++) {
+        if (entries[opcode].mnemonic[0] != '\0') {
+            slots[hash_mnemonic(entries[opcode].mnemonic, seed)] = opcode;
+        }
+    }
+    printf("const unsigned int mnemonic_hash_seed = %u;\n\n", seed);
+    printf("const signed char mnemonic_hash_table[MNEMONIC_HASH_SIZE] = {");
+    for (int slot = 0; slot < MNEMONIC_HASH_SIZE; slot++) {
+        const char *separator = slot == MNEMONIC_HASH_SIZE - 1 ? "" : (slot % 16 == 15 ? "," : ", ");
+        printf("%s%d%s", slot % 16 == 0 ? "\n    " : "", slots[slot], separator);
+    }
+    printf("\n};\n\n");
+}
+
+/**
+ * Writes the first word and legality flag of every opcode and addressing mode combination.
+ */
+static void write_encoding_table(void) {
+    printf("const EncodingEntry encoding_table[OPCODE_COUNT][MODE_COUNT][MODE_COUNT] = {\n");
+    for (int opcode = 0; opcode < OPCODE_COUNT; opcode++) {
+        printf("    { /* %s */\n", entries[opcode].mnemonic[0] != '\0' ? entries[opcode].mnemonic : "unused");
+        for (int source_mode = 0; source_mode < MODE_COUNT; source_mode++) {
+            printf("        {");
+            for (int target_mode = 0; target_mode < MODE_COUNT; target_mode++) {
+                printf("{0%05o, %d}%s", build_first_word(opcode, source_mode, target_mode),
+                       is_legal(opcode, source_mode, target_mode), target_mode < MODE_COUNT - 1 ? ", " : "");
+            }
+            printf("}%s\n", source_mode < MODE_COUNT - 1 ? "," : "");
+        }
+        printf("    }%s\n", opcode < OPCODE_COUNT - 1 ? "," : "");
+    }
+    printf("};\n\n");
+}
+
+/**
+ * Writes the decode table. A word is a valid first word when its A.R.E. field is absolute,
+ * each addressing mode field has at most one bit set, and the opcode allows those modes.
+ */
+static void write_decode_table(void) {
+    printf("const DecodedWord decode_table[DECODE_TABLE_SIZE] = {");
+    for (unsigned int word = 0; word < DECODE_TABLE_SIZE; word++) {
+        int opcode = (word >> 11) & 0xF;
+        int source_mode = mode_from_bits((word >> 7) & 0xF);
+        int target_mode = mode_from_bits((word >> 3) & 0xF);
+        DecodedWord decoded = {-1, 4, 4, 1};
+        if ((word & 0x7) == 4 && source_mode != -1 && target_mode != -1 &&
+            is_legal(opcode, source_mode, target_mode)) {
+            decoded.opcode = opcode;
+            decoded.source_mode = source_mode;
+            decoded.target_mode = target_mode;
+            decoded.length = 1 + (source_mode != 4) + (target_mode != 4);
+            /* Two register operands share one additional word */
+            if ((source_mode == 2 || source_mode == 3) && (target_mode == 2 || target_mode == 3)) {
+                decoded.length = 2;
+            }
+        }
+        printf("%s{%d,%d,%d,%d}%s", word % 8 == 0 ? "\n    " : "", decoded.opcode, decoded.source_mode,
+               decoded.target_mode, decoded.length, word < DECODE_TABLE_SIZE - 1 ? "," : "");
+    }
+    printf("\n};\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <description_file>\n", argv[0]);
+        return 1;
+    }
+    if (!read_description(argv[1])) {
+        return 1;
+    }
+    unsigned int seed;
+    if (!find_hash_seed(&seed)) {
+        fprintf(stderr, "gen_isa_tables: no collision-free hash seed for the mnemonics\n");
+        return 1;
+    }
+
+    printf("/* Generated by gen_isa_tables from %s. Do not edit. */\n", argv[1]);
+    printf("#include \"isa_tables.h\"\n\n");
+    write_opcode_table();
+    write_mnemonic_hash(seed);
+    write_encoding_table();
+    write_decode_table();
+    return 0;
+}
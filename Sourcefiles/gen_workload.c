@@ -0,0 +1,409 @@
+/**
+ * Workload Generator
+ *
+ * Purpose:
+ * Writes a synthetic assembly program for scale testing the assembler. The
+ * program is valid assembler input and is fully determined by its parameters
+ * and seed, so the same command always produces the same file.
+ *
+ * The program contains:
+ * - E externs, each referenced R times from the code.
+ * - M macros with K-line bodies, each called at least once.
+ * - N labels: three of every four label code, the fourth labels a data block of
+ *   D .data values (every second data block is a .string instead).
+ * - Instructions with random opcodes and every addressing mode their opcode allows.
+ *
+ * A program whose image would not fit in memory is not written and the generator
+ * fails, unless -f is given to write it anyway (its operand addresses then wrap).
+ *
+ * Usage: ./gen_workload [-n labels] [-m macros] [-k lines] [-e externs] [-r refs] [-d values] [-s seed] [-f]
+ *        > file.as
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "isa_tables.h"
+
+#define MEMORY_SIZE 4096
+#define FIRST_ADDRESS 100
+#define MAX_EXTERNAL_REFERENCES 100
+#define VALUES_PER_LINE 8
+#define MAX_STRING_LENGTH 30
+
+/**
+ * @brief The parameters of a workload.
+ */
+typedef struct {
+    int labels;       /* N: labels, code and data */
+    int macros;       /* M: macro definitions */
+    int macro_lines;  /* K: lines in each macro body */
+    int externs;      /* E: extern declarations */
+    int references;   /* R: references to each extern */
+    int data_values;  /* D: values in each .data block */
+    unsigned int seed;
+} WorkloadParameters;
+
+static unsigned int random_state;
+
+/**
+ * Returns the next number of a xorshift generator, so the output does not depend on the C library.
+ * @return A pseudo-random 32-bit number.
+ */
+static unsigned int next_random(void) {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+/**
+ * Returns a pseudo-random number in [0, limit).
+ * @param limit The upper bound; must be positive.
+ * @return The number.
+ */
+static int random_below(int limit) {
+    return (int)(next_random() % (unsigned int)limit);
+}
+
+/**
+ * Checks if a label holds data rather than code.
+ * @param index The index of the label.
+ * @return true for every fourth label, false otherwise.
+ */
+static bool is_data_label(int index) {
+    return index % 4 == 3;
+}
+
+/**
+ * Writes the name of a label: L<index> for code and D<index> for data.
+ * @param name Buffer for the name.
+ * @param index The index of the label.
+ */
+static void label_name(char *name, int index) {
+    sprintf(name, "%c%d", is_data_label(index) ? 'D' : 'L', index);
+}
+
+/**
+ * Picks one addressing mode from a bitmask of allowed modes.
+ * @param modes The allowed modes, one bit per mode.
+ * @return The chosen mode (0-3).
+ */
+static int pick_mode(int modes) {
+    int allowed[4];
+    int count = 0;
+    for (int mode = 0; mode < 4; mode++) {
+        if (modes & MODE_BIT(mode)) {
+            allowed[count++] = mode;
+        }
+    }
+    return allowed[random_below(count)];
+}
+
+/**
+ * Writes a random operand in the given addressing mode.
+ * @param operand Buffer for the operand.
+ * @param mode The addressing mode.
+ * @param parameters The workload parameters, for the number of labels.
+ */
+static void write_operand(char *operand, int mode, const WorkloadParameters *parameters) {
+    switch (mode) {
+        case 0:
+            sprintf(operand, "#%d", random_below(4096) - 2048);
+            break;
+        case 1:
+            if (parameters->labels > 0) {
+                label_name(operand, random_below(parameters->labels));
+            } else {
+                strcpy(operand, "MAIN");
+            }
+            break;
+        case 2:
+            sprintf(operand, "*r%d", random_below(8));
+            break;
+        default:
+            sprintf(operand, "r%d", random_below(8));
+            break;
+    }
+}
+
+/**
+ * Counts the words of an instruction with the given addressing modes.
+ * @param source_mode The source mode, or 4 if there is no source.
+ * @param target_mode The target mode, or 4 if there is no target.
+ * @return The length in words.
+ */
+static int instruction_words(int source_mode, int target_mode) {
+    bool source_register = source_mode == 2 || source_mode == 3;
+    bool target_register = target_mode == 2 || target_mode == 3;
+    if (source_register && target_register) {
+        return 2;
+    }
+    return 1 + (source_mode != 4) + (target_mode != 4);
+}
+
+/**
+ * Writes a random instruction with legal addressing modes.
+ * @param output The file to write to.
+ * @param label The label of the line, or NULL.
+ * @param parameters The workload parameters.
+ * @return The length of the instruction in words.
+ */
+static int write_instruction_line(FILE *output, const char *label, const WorkloadParameters *parameters) {
+    const OpcodeEntry *entry;
+    do {
+        entry = &opcode_table[random_below(OPCODE_COUNT)];
+    } while (entry->mnemonic[0] == '\0');
+
+    int source_mode = entry->source_modes != NO_OPERAND ? pick_mode(entry->source_modes) : 4;
+    int target_mode = entry->target_modes != NO_OPERAND ? pick_mode(entry->target_modes) : 4;
+    char source[16], target[16];
+
+    if (label) fprintf(output, "%s: ", label);
+    fprintf(output, "%s", entry->mnemonic);
+    if (source_mode != 4) {
+        write_operand(source, source_mode, parameters);
+        write_operand(target, target_mode, parameters);
+        fprintf(output, " %s, %s\n", source, target);
+    } else if (target_mode != 4) {
+        write_operand(target, target_mode, parameters);
+        fprintf(output, " %s\n", target);
+    } else {
+        fprintf(output, "\n");
+    }
+    return instruction_words(source_mode, target_mode);
+}
+
+/**
+ * Writes an instruction that references an external label.
+ * @param output The file to write to.
+ * @param extern_index The index of the external label.
+ * @return The length of the instruction in words.
+ */
+static int write_extern_reference(FILE *output, int extern_index) {
+    switch (random_below(4)) {
+        case 0:
+            fprintf(output, "jsr X%d\n", extern_index);
+            return 2;
+        case 1:
+            fprintf(output, "prn X%d\n", extern_index);
+            return 2;
+        case 2:
+            fprintf(output, "mov X%d, r%d\n", extern_index, random_below(8));
+            return 3;
+        default:
+            fprintf(output, "cmp #%d, X%d\n", random_below(100), extern_index);
+            return 3;
+    }
+}
+
+/**
+ * Writes a data block: D .data values, VALUES_PER_LINE to a line, or for every second
+ * data label a .string of up to MAX_STRING_LENGTH letters.
+ * @param output The file to write to.
+ * @param index The index of the data label.
+ * @param parameters The workload parameters.
+ * @return The length of the block in words.
+ */
+static int write_data_block(FILE *output, int index, const WorkloadParameters *parameters) {
+    char name[16];
+    label_name(name, index);
+
+    if ((index / 4) % 2 == 1) {
+        int length = 1 + random_below(MAX_STRING_LENGTH);
+        fprintf(output, "%s: .string \"", name);
+        for (int i = 0; i < length; i++) {
+            fputc('a' + random_below(26), output);
+        }
+        fprintf(output, "\"\n");
+        return length + 1;
+    }
+
+    int count = parameters->data_values > 0 ? parameters->data_values : 1;
+    for (int i = 0; i < count; i++) {
+        if (i == 0) {
+            fprintf(output, "%s: .data ", name);
+        } else if (i % VALUES_PER_LINE == 0) {
+            fprintf(output, "\n.data ");
+        } else {
+            fprintf(output, ", ");
+        }
+        fprintf(output, "%d", random_below(16384) - 8192);
+    }
+    fprintf(output, "\n");
+    return count;
+}
+
+/**
+ * Writes the whole workload.
+ * @param output The file to write to.
+ * @param parameters The workload parameters.
+ * @return The estimated image size in words.
+ */
+static int write_workload(FILE *output, const WorkloadParameters *parameters) {
+    int *macro_words = calloc(parameters->macros > 0 ? parameters->macros : 1, sizeof(int));
+    int words = 0;
+    char name[16];
+
+    fprintf(output, "; Generated by gen_workload -n %d -m %d -k %d -e %d -r %d -d %d -s %u\n",
+            parameters->labels, parameters->macros, parameters->macro_lines, parameters->externs,
+            parameters->references, parameters->data_values, parameters->seed);
+
+    for (int i = 0; i < parameters->externs; i++) {
+        fprintf(output, ".extern X%d\n", i);
+    }
+
+    /* Macro bodies are unlabeled, since each call repeats them */
+    for (int i = 0; i < parameters->macros; i++) {
+        fprintf(output, "macr m%d\n", i);
+        for (int j = 0; j < parameters->macro_lines; j++) {
+            fprintf(output, "    ");
+            macro_words[i] += write_instruction_line(output, NULL, parameters);
+        }
+        fprintf(output, "endmacr\n");
+    }
+
+    fprintf(output, ".entry MAIN\n");
+    words += write_instruction_line(output, "MAIN", parameters);
+
+    /* Code: each code label is followed by a few plain lines, macro calls and extern references */
+    int code_labels = 0;
+    for (int i = 0; i < parameters->labels; i++) {
+        if (!is_data_label(i)) code_labels++;
+    }
+    int pending_references = parameters->externs * parameters->references;
+    int next_reference = 0;
+    int macro_calls = 0;
+    int code_label = 0;
+    for (int i = 0; i < parameters->labels; i++) {
+        if (is_data_label(i)) continue;
+        label_name(name, i);
+        words += write_instruction_line(output, name, parameters);
+
+        int lines = random_below(4);
+        for (int j = 0; j < lines; j++) {
+            if (parameters->macros > 0 && random_below(4) == 0) {
+                int macro = macro_calls++ % parameters->macros;
+                fprintf(output, "m%d\n", macro);
+                words += macro_words[macro];
+            } else {
+                words += write_instruction_line(output, NULL, parameters);
+            }
+        }
+
+        /* Spread the extern references evenly over the code labels */
+        code_label++;
+        int references = pending_references / (code_labels - code_label + 1);
+        for (int j = 0; j < references; j++) {
+            words += write_extern_reference(output, next_reference++ % parameters->externs);
+        }
+        pending_references -= references;
+    }
+
+    /* Macros are called in turn, so this calls the ones not called yet */
+    for (; macro_calls < parameters->macros; macro_calls++) {
+        fprintf(output, "m%d\n", macro_calls);
+        words += macro_words[macro_calls];
+    }
+    for (; pending_references > 0; pending_references--) {
+        words += write_extern_reference(output, next_reference++ % parameters->externs);
+    }
+    fprintf(output, "stop\n");
+    words++;
+
+    for (int i = 0; i < parameters->labels; i++) {
+        if (is_data_label(i)) {
+            words += write_data_block(output, i, parameters);
+        }
+    }
+
+    free(macro_words);
+    return words;
+}
+
+/**
+ * Reads a non-negative integer option value.
+ * @param text The value as given on the command line.
+ * @param value Set to the value if it is valid.
+ * @return true if the value is a non-negative integer, false otherwise.
+ */
+static bool parse_count(const char *text, int *value) {
+    char *end;
+    long parsed = strtol(text, &end, 10);
+    if (*text == '\0' || *end != '\0' || parsed < 0 || parsed > 1000000) {
+        return false;
+    }
+    *value = (int)parsed;
+    return true;
+}
+
+/**
+ * Copies a file to another from its beginning.
+ * @param from The file to copy.
+ * @param to The file to write to.
+ */
+static void copy_file(FILE *from, FILE *to) {
+    char buffer[4096];
+    size_t length;
+    rewind(from);
+    while ((length = fread(buffer, 1, sizeof(buffer), from)) > 0) {
+        fwrite(buffer, 1, length, to);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    WorkloadParameters parameters = {100, 5, 4, 5, 3, 10, 1};
+    int seed = 1;
+    bool force = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-f") == 0) {
+            force = true;
+            continue;
+        }
+        int *value = NULL;
+        if (strcmp(argv[i], "-n") == 0) value = &parameters.labels;
+        else if (strcmp(argv[i], "-m") == 0) value = &parameters.macros;
+        else if (strcmp(argv[i], "-k") == 0) value = &parameters.macro_lines;
+        else if (strcmp(argv[i], "-e") == 0) value = &parameters.externs;
+        else if (strcmp(argv[i], "-r") == 0) value = &parameters.references;
+        else if (strcmp(argv[i], "-d") == 0) value = &parameters.data_values;
+        else if (strcmp(argv[i], "-s") == 0) value = &seed;
+
+        if (value == NULL || i + 1 >= argc || !parse_count(argv[++i], value)) {
+            fprintf(stderr, "Usage: %s [-n labels] [-m macros] [-k lines] [-e externs] [-r refs] [-d values] "
+                    "[-s seed] [-f]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    /* The .ext file keeps at most MAX_EXTERNAL_REFERENCES references per extern */
+    if (parameters.references > MAX_EXTERNAL_REFERENCES) {
+        fprintf(stderr, "gen_workload: -r limited to %d\n", MAX_EXTERNAL_REFERENCES);
+        parameters.references = MAX_EXTERNAL_REFERENCES;
+    }
+    parameters.seed = (unsigned int)seed;
+    random_state = parameters.seed != 0 ? parameters.seed : 1; /* xorshift never leaves 0 */
+
+    /* The size is only known once the program is written, so it is written to a temporary file first */
+    FILE *program = tmpfile();
+    if (!program) {
+        fprintf(stderr, "gen_workload: cannot create a temporary file\n");
+        return 1;
+    }
+    int words = write_workload(program, &parameters);
+    if (words > MEMORY_SIZE - FIRST_ADDRESS) {
+        if (!force) {
+            fprintf(stderr, "gen_workload: the image has %d words and does not fit in the %d words of memory; "
+                    "use smaller parameters, or -f to write it anyway\n", words, MEMORY_SIZE - FIRST_ADDRESS);
+            fclose(program);
+            return 1;
+        }
+        fprintf(stderr, "gen_workload: the image has %d words and does not fit in memory; "
+                "addresses in operands will wrap\n", words);
+    }
+    copy_file(program, stdout);
+    fclose(program);
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "line_map.h"
+#include "error_handling.h"
+
+/**
+ * Initializes the line map with default values and allocates initial memory.
+ * @param map Pointer to the line map to initialize.
+ */
+void init_line_map(LineMap *map) {
+    map->count = 0;
+    map->capacity = 16;
+    map->ranges = malloc(sizeof(LineRange) * map->capacity);
+}
+
+/**
+ * Adds a range of addresses to the line map. Words emitted by the same source line
+ * at consecutive addresses are merged into one range, which keeps the table compact.
+ * @param map Pointer to the line map.
+ * @param start_address The first address of the range.
+ * @param length The number of words in the range.
+ * @param source_line The line number in the original .as file.
+ * @param expansion_line The line of the macro call that produced the line, or 0.
+ */
+void add_line_range(LineMap *map, int start_address, int length, int source_line, int expansion_line) {
+    if (length <= 0 || map->ranges == NULL) return;
+
+    /* Extend the previous range if this one directly continues it */
+    if (map->count > 0) {
+        LineRange *last = &map->ranges[map->count - 1];
+        if (last->end_address + 1 == start_address && last->source_line == source_line &&
+            last->expansion_line == expansion_line) {
+            last->end_address += length;
+            return;
+        }
+    }
+
+    /* Resize the line map if necessary */
+    if (map->count == map->capacity) {
+        LineRange *new_ranges = realloc(map->ranges, sizeof(LineRange) * map->capacity * 2);
+        if (new_ranges == NULL) {
+            log_error(ERR_MEMORY, "Failed to resize line map", "line_map", source_line);
+            return;
+        }
+        map->ranges = new_ranges;
+        map->capacity *= 2;
+    }
+
+    LineRange *range = &map->ranges[map->count++];
+    range->start_address = start_address;
+    range->end_address = start_address + length - 1;
+    range->source_line = source_line;
+    range->expansion_line = expansion_line;
+}
+
+/**
+ * Frees the memory allocated for the line map.
+ * @param map Pointer to the line map to free.
+ */
+void free_line_map(LineMap *map) {
+    free(map->ranges);
+    map->ranges = NULL;
+    map->count = 0;
+    map->capacity = 0;
+}
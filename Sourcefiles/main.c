@@ -10,6 +10,8 @@
  * - Macro expansion: Supports definition and expansion of macros in the source code.
  * - Symbol resolution: Handles labels, entry points, and external references.
  * - Instruction encoding: Converts assembly instructions into binary machine code.
+ * - Constant expressions: Operands and .data values such as LABEL+3, #4*2 and
+ *   END-START are folded at assembly time.
  * - Error detection and reporting: Identifies and reports syntax and semantic errors.
  * - Output generation: Produces object (.ob), entry (.ent), and external (.ext) files.
  * 
@@ -28,7 +30,24 @@
  *    - Completes the encoding of instructions.
  *    - Generates the final object file and auxiliary files (.ent and .ext).
  * 
- * Usage: ./assembler <input_file1> [input_file2] ...
+ * Usage: ./assembler [options] <input_file1> [input_file2] ...
+ * 
+ * Options:
+ * - --line-map: Also write a .lin file mapping address ranges back to .as source lines.
+ * - --cost-report: Print the estimated code size and cycle cost of each label.
+ * - --verify: Disassemble each object file, assemble the result again and check
+ *   that both images are identical word for word.
+ *   A file that does not assemble also makes the exit status 1.
+ * - -O1: Remove no-op instructions and unreachable code, shorten mov #0 to clr and
+ *   drop jumps to the next instruction before the second pass. The .am file shows the result.
+ *   Files with address expressions such as LABEL+3 are not optimized.
+ * - -O0: Do not optimize (the default).
+ * - --pool-data: Lay out identical .data and .string blocks only once when no
+ *   instruction writes to them.
+ * - --time-report: Print the wall and CPU time of each phase, with lines and
+ *   bytes of source per second, for each file and for all files together.
+ * - --memory-report: Print the allocations, bytes requested, bytes moved by realloc
+ *   and peak live bytes of each phase, for each file and for all files together.
  * 
  * The program expects one or more input files as command-line arguments.
  * Each file is processed independently, and any errors encountered during
@@ -49,6 +68,7 @@
  * - An object file (.ob) containing the encoded instructions and data.
  * - An entry file (.ent) listing all entry symbols, if any are defined.
  * - An external file (.ext) listing all external symbol references, if any are used.
+ * - A line map file (.lin) listing address ranges and their source lines, if --line-map is given.
  * 
  * Error handling:
  * The assembler detects and reports various types of errors, including:
@@ -66,7 +86,136 @@
 #include "symbol_table.h"
 #include "first_pass.h"
 #include "error_handling.h"
+#include "options.h"
+#include "disassembler.h"
+#include "time_report.h"
+#include "alloc_stats.h"
+
+/**
+ * Assembles one input file: runs the pre-assembler, then the first pass, which runs the
+ * second pass and generates the output files.
+ * @param input_filename The name of the input file, without the .as extension.
+ * @return true if the file was assembled successfully, false otherwise.
+ */
+static bool assemble_file(const char *input_filename) {
+    char full_filename[MAX_FILENAME];
+    snprintf(full_filename, sizeof(full_filename), "%s.as", input_filename);
+
+    /* Step 1: Pre-assembly (macro expansion) */
+    start_phase(PHASE_PRE_ASSEMBLY);
+    char *expanded_filename = pre_assembler(full_filename);
+    end_phase();
+    if (!expanded_filename) {
+        log_error(ERR_FILE_INPUT, "Pre-assembler failed", input_filename, -1);
+        free_line_origins();
+        return false;
+    }
+    printf("Pre-assembler done for file: %s\n", full_filename);
+
+    /* Step 2: First pass, which runs the second pass */
+    SymbolTable symbol_table;
+    init_symbol_table(&symbol_table);
+    start_phase(PHASE_FIRST_PASS);
+    bool assembled = first_pass(expanded_filename, &symbol_table);
+    end_phase();
+    if (assembled) {
+        printf("First and second pass are done for file : %s\n", full_filename);
+    } else {
+        log_error(ERR_SEMANTIC, "Assembly failed", expanded_filename, -1);
+    }
+
+    /* Clean up resources */
+    counted_free(expanded_filename);
+    free_symbol_table(&symbol_table);
+    free_external_table(&symbol_table.external_table);
+    free_line_origins();
+    return assembled;
+}
 
+/**
+ * Compares two object images word by word and logs the first difference.
+ * @param original The image produced from the input file.
+ * @param copy The image produced from its disassembly.
+ * @param input_filename The name of the input file, for error reporting.
+ * @return true if the images are identical, false otherwise.
+ */
+static bool compare_images(const ObjectImage *original, const ObjectImage *copy, const char *input_filename) {
+    char message[80];
+    if (original->code_length != copy->code_length || original->data_length != copy->data_length) {
+        snprintf(message, sizeof(message), "Round trip changed the image size from %d %d to %d %d",
+                 original->code_length, original->data_length, copy->code_length, copy->data_length);
+        log_error(ERR_SEMANTIC, message, input_filename, -1);
+        return false;
+    }
+    int end = FIRST_ADDRESS + original->code_length + original->data_length;
+    for (int address = FIRST_ADDRESS; address < end; address++) {
+        if (original->words[address] != copy->words[address]) {
+            snprintf(message, sizeof(message), "Round trip mismatch at address %04d: %05o became %05o",
+                     address, original->words[address], copy->words[address]);
+            log_error(ERR_SEMANTIC, message, input_filename, -1);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Verifies an assembled file by a round trip: its object image is disassembled, the text is
+ * assembled again as <input>_rt.as, and the two images are compared word by word. The
+ * intermediate files are kept for inspection if the images differ.
+ * @param input_filename The name of the input file, without the .as extension.
+ * @return true if both images are identical, false otherwise.
+ */
+static bool verify_round_trip(const char *input_filename) {
+    static const char *extensions[] = {".as", ".am", ".ob", ".ent", ".ext"};
+    /* Room for the _rt suffix and the longest extension */
+    char round_trip_name[MAX_FILENAME + 3];
+    char filename[MAX_FILENAME + 7];
+    snprintf(round_trip_name, sizeof(round_trip_name), "%s_rt", input_filename);
+
+    ObjectImage *original = load_object_image(input_filename);
+    if (!original) {
+        return false;
+    }
+
+    /* Remove outputs of an earlier run so a failed reassembly can't be compared against them */
+    for (size_t j = 0; j < sizeof(extensions) / sizeof(extensions[0]); j++) {
+        snprintf(filename, sizeof(filename), "%s%s", round_trip_name, extensions[j]);
+        remove(filename);
+    }
+
+    snprintf(filename, sizeof(filename), "%s.as", round_trip_name);
+    FILE *output = fopen(filename, "w");
+    if (!output) {
+        log_error(ERR_FILE_OUTPUT, "Failed to create round trip file", filename, -1);
+        free_object_image(original);
+        return false;
+    }
+    disassemble_image(original, output);
+    fclose(output);
+
+    /* Reassemble with every option off, so -O1 and --pool-data cannot change the image and no reports are written */
+    AssemblerOptions saved_options = assembler_options;
+    memset(&assembler_options, 0, sizeof(assembler_options));
+    bool reassembled = assemble_file(round_trip_name);
+    assembler_options = saved_options;
+
+    ObjectImage *copy = reassembled ? load_object_image(round_trip_name) : NULL;
+    bool identical = copy != NULL && compare_images(original, copy, input_filename);
+    if (identical) {
+        for (size_t j = 0; j < sizeof(extensions) / sizeof(extensions[0]); j++) {
+            snprintf(filename, sizeof(filename), "%s%s", round_trip_name, extensions[j]);
+            remove(filename);
+        }
+        printf("Round trip verified for file: %s.as\n", input_filename);
+    }
+
+    free_object_image(original);
+    if (copy) {
+        free_object_image(copy);
+    }
+    return identical;
+}
 
 /**
  * The main function of the assembler program.
@@ -85,7 +234,8 @@
  * @param argv An array of strings containing the command-line arguments.
  *             argv[0] is the program name, and subsequent elements are input filenames.
  * 
- * @return 0 if the program executes successfully, 1 if no input files were provided.
+ * @return 0 if the program executes successfully, 1 if no input files were provided
+ *         or a file given with --verify did not assemble or failed its round trip.
  * 
  * Note: The function continues processing subsequent files even if errors occur in one file.
  *       This allows for batch processing of multiple files, with errors reported at the end.
@@ -98,9 +248,23 @@ int main(int argc, char *argv[]) {
         return 1;
     }
     int valid_files = 0;
+    int verify_failures = 0;
+    TimeReport total_times;
+    reset_time_report(&total_times);
+    MemoryReport total_memory = {{{0}}};
     int i = 1;
+    /* Apply all options first so they affect every input file */
+    for (int j = 1; j < argc; j++) {
+        if (is_option(argv[j]) && !parse_option(argv[j])) {
+            log_error(ERR_FILE_INPUT, "Unknown option", argv[j], -1);
+        }
+    }
     /* Process each input file */
     while (i < argc) {
+        if (is_option(argv[i])) {
+            i++;
+            continue;  /* Options were already applied */
+        }
         char input_filename[MAX_FILENAME];
         char full_filename[MAX_FILENAME];
 
@@ -119,29 +283,23 @@ int main(int argc, char *argv[]) {
         }
         fclose(file);
         valid_files++;
-        /* Step 1: Pre-assembly (macro expansion) */
-        char *expanded_filename = pre_assembler(full_filename);
-        if (!expanded_filename) {
-            log_error(ERR_FILE_INPUT, "Pre-assembler failed", input_filename, -1);
-            i++;
-            continue;  /* Skip to the next file if pre-assembly fails */
+        reset_time_report(&phase_times);
+        measure_source(full_filename, &phase_times);
+        start_memory_report();
+        /* Steps 1-3: Pre-assembly, first pass and second pass */
+        bool assembled = assemble_file(input_filename);
+        if (assembler_options.time_report) {
+            print_time_report(&phase_times, full_filename);
+            add_time_report(&total_times, &phase_times);
         }
-        printf("Pre-assembler done for file: %s\n", full_filename);
-        /* Step 2: First pass */
-        SymbolTable symbol_table;
-        init_symbol_table(&symbol_table);
-        if (!first_pass(expanded_filename, &symbol_table)) {
-            log_error(ERR_SEMANTIC, "First pass failed", expanded_filename, -1);
-            free(expanded_filename);
-            free_symbol_table(&symbol_table);
-            i++;
-            continue;  /* Skip to the next file if first pass fails */
+        if (assembler_options.memory_report) {
+            print_memory_report(&memory_usage, full_filename);
+            add_memory_report(&total_memory, &memory_usage);
+        }
+        /* A file that does not assemble cannot be verified, so it counts as a failed round trip */
+        if (assembler_options.verify && (!assembled || !verify_round_trip(input_filename))) {
+            verify_failures++;
         }
-        printf("First and second pass are done for file : %s\n", full_filename);
-        /* Clean up resources */
-        free(expanded_filename);
-        free_symbol_table(&symbol_table);
-        free_external_table(&symbol_table.external_table);
         i++;
        }
 
@@ -149,8 +307,14 @@ int main(int argc, char *argv[]) {
         log_error(ERR_FILE_INPUT, "No valid input files to process", "main", -1);
         return 1;
     }
+    if (assembler_options.time_report) {
+        print_time_report(&total_times, "all files");
+    }
+    if (assembler_options.memory_report) {
+        print_memory_report(&total_memory, "all files");
+    }
     /* Print a summary of all errors encountered during assembly */
     print_error_summary();
     
-    return 0;
+    return verify_failures == 0 ? 0 : 1;
 }
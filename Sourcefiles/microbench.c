@@ -0,0 +1,342 @@
+/**
+ * Microbenchmarks
+ *
+ * Purpose:
+ * Times the assembler's hot helper functions one at a time, so a lookup or
+ * formatting change can be measured on its own instead of through a whole
+ * assembly run.
+ *
+ * Each function is called on inputs drawn from the token mix of typical
+ * source files (mnemonic frequencies, operand kinds, spacing and label
+ * counts), generated with a fixed seed. Every benchmark is run SAMPLES times;
+ * the report gives the mean, standard deviation, minimum and maximum of the
+ * nanoseconds per call over the samples.
+ *
+ * trim() and handle_extra_spaces() modify their argument, so each call first
+ * copies a line into a buffer. The cost of that copy is measured separately
+ * and subtracted.
+ *
+ * Usage: ./microbench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "utilities.h"
+#include "opcode_table.h"
+#include "pre_assembler.h"
+#include "symbol_table.h"
+
+#define SAMPLES 15
+#define CALLS_PER_SAMPLE 200000
+#define INPUT_COUNT 4096 /* Power of two, so inputs are picked with a mask */
+#define SYMBOL_COUNT 1000 /* Labels in a large source file */
+
+/**
+ * @brief A token and how often it appears in typical source.
+ */
+typedef struct {
+    const char *token;
+    int weight;
+} WeightedToken;
+
+/* First tokens of statements: mnemonics by frequency, then directives, labels and macro calls */
+static const WeightedToken statement_tokens[] = {
+    {"mov", 20}, {"cmp", 10}, {"add", 8}, {"sub", 6}, {"lea", 5}, {"clr", 4}, {"not", 2}, {"inc", 6},
+    {"dec", 5}, {"jmp", 6}, {"bne", 6}, {"red", 2}, {"prn", 6}, {"jsr", 5}, {"rts", 4}, {"stop", 2},
+    {".data", 8}, {".string", 4}, {".entry", 2}, {".extern", 2}, {"LOOP", 4}, {"MAIN", 2}, {"m_print", 3}
+};
+
+/* Lines as they come from source files, with their irregular spacing */
+static const char *source_lines[] = {
+    "MAIN:\tadd\tr3, LIST\n", "    mov   r1 ,  r2   \n", "LOOP: prn #48\n", "\tlea\tSTR, r6\n",
+    "inc r6\n", "   cmp    r3,    #-6\n", "bne END\n", "STR: .string \"abcd\"\n",
+    "LIST:\t.data\t6, -9\n", "  .data   -100  \n", "K: .data 31\n", "END:   stop\n",
+    "jsr    fn1\n", "\tmov\t*r6, L3\n", "sub r1, r4\n", "  .entry   MAIN\n"
+};
+
+/* Instructions as they appear in code, for the encoder; %s is a label of the lookup table */
+static const char *instructions[][2] = {
+    {"mov", "r1, r2"}, {"mov", "#5, %s"}, {"cmp", "r3, #-6"}, {"add", "r7, *r6"}, {"sub", "%s, %s"},
+    {"lea", "%s, r6"}, {"clr", "%s"}, {"inc", "r6"}, {"dec", "*r2"}, {"jmp", "%s"}, {"bne", "%s"},
+    {"prn", "#48"}, {"jsr", "%s"}, {"rts", ""}, {"stop", ""}, {"red", "r1"}
+};
+
+static unsigned int random_state = 1;
+static volatile long sink; /* Results go here so the calls cannot be optimized away */
+
+static const char *tokens[INPUT_COUNT];
+static const char *operands[INPUT_COUNT];
+static const char *lines[INPUT_COUNT];
+static char symbol_names[SYMBOL_COUNT][MAX_LABEL_LENGTH + 1];
+static const char *lookup_names[INPUT_COUNT];
+static Instruction encoded[INPUT_COUNT];
+static SymbolTable lookup_table;
+static FILE *null_output;
+
+/**
+ * Returns the next number of a xorshift generator.
+ * @return A pseudo-random 32-bit number.
+ */
+static unsigned int next_random(void) {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+/**
+ * Picks a token according to its weight.
+ * @param table The weighted tokens.
+ * @param count The number of tokens.
+ * @return The chosen token.
+ */
+static const char *pick_weighted(const WeightedToken *table, int count) {
+    int total = 0;
+    for (int i = 0; i < count; i++) total += table[i].weight;
+    int pick = (int)(next_random() % (unsigned int)total);
+    for (int i = 0; i < count; i++) {
+        pick -= table[i].weight;
+        if (pick < 0) return table[i].token;
+    }
+    return table[count - 1].token;
+}
+
+/**
+ * Reads the monotonic clock.
+ * @return The time in nanoseconds.
+ */
+static double now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+/**
+ * Builds the inputs of every benchmark.
+ * @return true if every instruction was encoded, false otherwise.
+ */
+static bool prepare_inputs(void) {
+    static const char *operand_kinds[] = {"r1", "r6", "r3", "r7", "LIST", "LOOP", "L3", "#48", "#-6", "*r6"};
+    static const int operand_weights[] = {12, 10, 10, 8, 8, 8, 6, 10, 8, 10};
+    WeightedToken operand_table[10];
+    for (int i = 0; i < 10; i++) {
+        operand_table[i].token = operand_kinds[i];
+        operand_table[i].weight = operand_weights[i];
+    }
+
+    init_symbol_table(&lookup_table);
+    for (int i = 0; i < SYMBOL_COUNT; i++) {
+        sprintf(symbol_names[i], "LABEL%d", i);
+        add_symbol(&lookup_table, symbol_names[i], 100 + i, SYMBOL_TYPE_CODE, "microbench", i);
+    }
+
+    for (int i = 0; i < INPUT_COUNT; i++) {
+        tokens[i] = pick_weighted(statement_tokens, sizeof(statement_tokens) / sizeof(statement_tokens[0]));
+        operands[i] = pick_weighted(operand_table, 10);
+        lines[i] = source_lines[next_random() % (sizeof(source_lines) / sizeof(source_lines[0]))];
+        /* Nine lookups in ten find their label; the rest miss, like operands of later passes */
+        lookup_names[i] = next_random() % 10 != 0 ? symbol_names[next_random() % SYMBOL_COUNT] : "MISSING";
+
+        int choice = next_random() % (sizeof(instructions) / sizeof(instructions[0]));
+        const char *label = symbol_names[next_random() % SYMBOL_COUNT];
+        char instruction_operands[MAX_LINE_LENGTH + 1];
+        snprintf(instruction_operands, sizeof(instruction_operands), instructions[choice][1], label, label);
+        encoded[i] = encode_instruction(instructions[choice][0], instruction_operands, &lookup_table, 100);
+        if (encoded[i].opcode == -1) {
+            fprintf(stderr, "microbench: cannot encode %s %s\n", instructions[choice][0], instruction_operands);
+            return false;
+        }
+    }
+    null_output = fopen("/dev/null", "w");
+    if (!null_output) {
+        fprintf(stderr, "microbench: cannot open /dev/null\n");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Looks up the first tokens of statements, mnemonics or not.
+ * @param calls The number of calls to time.
+ */
+static void bench_get_opcode(int calls) {
+    long total = 0;
+    for (int i = 0; i < calls; i++) total += get_opcode(tokens[i & (INPUT_COUNT - 1)]);
+    sink = total;
+}
+
+/**
+ * Checks the first tokens of statements against the reserved words, as macro and label definitions are.
+ * @param calls The number of calls to time.
+ */
+static void bench_is_reserved_word(int calls) {
+    long total = 0;
+    for (int i = 0; i < calls; i++) total += is_reserved_word(tokens[i & (INPUT_COUNT - 1)]);
+    sink = total;
+}
+
+/**
+ * Looks up labels in a table of SYMBOL_COUNT symbols; one lookup in ten misses.
+ * @param calls The number of calls to time.
+ */
+static void bench_find_symbol(int calls) {
+    long total = 0;
+    for (int i = 0; i < calls; i++) total += find_symbol(&lookup_table, lookup_names[i & (INPUT_COUNT - 1)]) != NULL;
+    sink = total;
+}
+
+/**
+ * Fills fresh tables to SYMBOL_COUNT labels, as the first pass of a large file does.
+ * @param calls The number of calls to time.
+ */
+static void bench_add_symbol(int calls) {
+    SymbolTable table;
+    init_symbol_table(&table);
+    for (int i = 0; i < calls; i++) {
+        if (i % SYMBOL_COUNT == 0 && i > 0) {
+            free_symbol_table(&table);
+            free_external_table(&table.external_table);
+            init_symbol_table(&table);
+        }
+        add_symbol(&table, symbol_names[i % SYMBOL_COUNT], 100 + i, SYMBOL_TYPE_CODE, "microbench", i);
+    }
+    sink = table.size;
+    free_symbol_table(&table);
+    free_external_table(&table.external_table);
+}
+
+/**
+ * Classifies operands: registers, labels, immediates and indirect registers.
+ * @param calls The number of calls to time.
+ */
+static void bench_get_addressing_mode(int calls) {
+    long total = 0;
+    for (int i = 0; i < calls; i++) total += get_addressing_mode(operands[i & (INPUT_COUNT - 1)]);
+    sink = total;
+}
+
+/**
+ * Only copies source lines into a buffer; the cost subtracted from the line benchmarks.
+ * @param calls The number of calls to time.
+ */
+static void bench_copy_line(int calls) {
+    char buffer[MAX_LINE_LENGTH + 1];
+    long total = 0;
+    for (int i = 0; i < calls; i++) {
+        strcpy(buffer, lines[i & (INPUT_COUNT - 1)]);
+        total += buffer[0];
+    }
+    sink = total;
+}
+
+/**
+ * Trims copies of source lines.
+ * @param calls The number of calls to time.
+ */
+static void bench_trim(int calls) {
+    char buffer[MAX_LINE_LENGTH + 1];
+    long total = 0;
+    for (int i = 0; i < calls; i++) {
+        strcpy(buffer, lines[i & (INPUT_COUNT - 1)]);
+        trim(buffer);
+        total += buffer[0];
+    }
+    sink = total;
+}
+
+/**
+ * Collapses the spacing of copies of source lines.
+ * @param calls The number of calls to time.
+ */
+static void bench_handle_extra_spaces(int calls) {
+    char buffer[MAX_LINE_LENGTH + 1];
+    long total = 0;
+    for (int i = 0; i < calls; i++) {
+        strcpy(buffer, lines[i & (INPUT_COUNT - 1)]);
+        handle_extra_spaces(buffer);
+        total += buffer[0];
+    }
+    sink = total;
+}
+
+/**
+ * Writes encoded instructions to /dev/null.
+ * @param calls The number of calls to time.
+ */
+static void bench_write_instruction(int calls) {
+    for (int i = 0; i < calls; i++) write_instruction(null_output, encoded[i & (INPUT_COUNT - 1)], 100 + i % 3000);
+}
+
+/**
+ * @brief A benchmark and what to subtract from it.
+ */
+typedef struct {
+    const char *name;
+    void (*run)(int calls);
+    bool subtract_copy; /* Subtract the cost of copying the input line */
+} Benchmark;
+
+/**
+ * Times a benchmark SAMPLES times after one warm-up sample.
+ * @param run The benchmark body.
+ * @param samples Set to the nanoseconds per call of each sample.
+ */
+static void measure(void (*run)(int calls), double samples[SAMPLES]) {
+    run(CALLS_PER_SAMPLE);
+    for (int s = 0; s < SAMPLES; s++) {
+        double start = now_ns();
+        run(CALLS_PER_SAMPLE);
+        samples[s] = (now_ns() - start) / CALLS_PER_SAMPLE;
+    }
+}
+
+int main(void) {
+    static const Benchmark benchmarks[] = {
+        {"get_opcode", bench_get_opcode, false},
+        {"is_reserved_word", bench_is_reserved_word, false},
+        {"find_symbol", bench_find_symbol, false},
+        {"add_symbol", bench_add_symbol, false},
+        {"get_addressing_mode", bench_get_addressing_mode, false},
+        {"trim", bench_trim, true},
+        {"handle_extra_spaces", bench_handle_extra_spaces, true},
+        {"write_instruction", bench_write_instruction, false}
+    };
+
+    if (!prepare_inputs()) {
+        free_symbol_table(&lookup_table);
+        free_external_table(&lookup_table.external_table);
+        return 1;
+    }
+
+    double copy_samples[SAMPLES];
+    double copy_mean = 0;
+    measure(bench_copy_line, copy_samples);
+    for (int s = 0; s < SAMPLES; s++) copy_mean += copy_samples[s] / SAMPLES;
+
+    printf("%d samples of %d calls; %d symbols in the lookup table\n", SAMPLES, CALLS_PER_SAMPLE, SYMBOL_COUNT);
+    printf("%-20s %10s %10s %10s %10s\n", "Function", "ns/call", "stddev", "min", "max");
+    for (size_t b = 0; b < sizeof(benchmarks) / sizeof(benchmarks[0]); b++) {
+        double samples[SAMPLES];
+        measure(benchmarks[b].run, samples);
+
+        double mean = 0, variance = 0, min = samples[0], max = samples[0];
+        for (int s = 0; s < SAMPLES; s++) {
+            if (benchmarks[b].subtract_copy) samples[s] -= copy_mean;
+            mean += samples[s] / SAMPLES;
+        }
+        for (int s = 0; s < SAMPLES; s++) {
+            variance += (samples[s] - mean) * (samples[s] - mean) / (SAMPLES - 1);
+            if (samples[s] < min) min = samples[s];
+            if (samples[s] > max) max = samples[s];
+        }
+        printf("%-20s %10.2f %10.2f %10.2f %10.2f\n", benchmarks[b].name, mean, sqrt(variance), min, max);
+    }
+
+    fclose(null_output);
+    free_symbol_table(&lookup_table);
+    free_external_table(&lookup_table.external_table);
+    return 0;
+}
@@ -2,48 +2,69 @@
 #include <stdlib.h>
 #include <string.h>
 #include "opcode_table.h"
+#include "isa_tables.h"
+
+/*
+ * The opcode table itself is generated from isa_description.txt into isa_tables.c,
+ * together with a perfect hash over its mnemonics.
+ */
 
-static const OpcodeEntry opcode_table[] = {
-    {"mov", 0, 2},
-    {"cmp", 1, 2},
-    {"add", 2, 2},
-    {"sub", 3, 2},
-    {"lea", 4, 2},
-    {"clr", 5, 1},
-    {"not", 6, 1},
-    {"inc", 7, 1},
-    {"dec", 8, 1},
-    {"jmp", 9, 1},
-    {"bne", 10, 1},
-    {"red", 11, 1},
-    {"prn", 12, 1},
-    {"jsr", 13, 1},
-    {"rts", 14, 0},
-    {"stop", 15, 0}
-};
 /**
- * Searches the opcode table for a given mnemonic and returns its opcode.
+ * Looks up a mnemonic in the perfect hash and returns its opcode.
  * @param mnemonic The instruction mnemonic to look up.
  * @return The opcode if the mnemonic is found, -1 otherwise.
  */
 int get_opcode(const char *mnemonic) {
-    for (size_t i = 0; i < sizeof(opcode_table) / sizeof(opcode_table[0]); i++) {
-        if (strcmp(opcode_table[i].mnemonic, mnemonic) == 0) {
-            return opcode_table[i].opcode;
-        }
+    int opcode = mnemonic_hash_table[hash_mnemonic(mnemonic, mnemonic_hash_seed)];
+    /* Each mnemonic has its own slot, so one comparison confirms the match */
+    if (opcode != -1 && strcmp(opcode_table[opcode].mnemonic, mnemonic) == 0) {
+        return opcode;
     }
     return -1;  
 }
 /**
- * Searches the opcode table for a given mnemonic and returns the number of operands it expects.
+ * Looks up a mnemonic and returns the number of operands it expects.
  * @param mnemonic The instruction mnemonic to look up.
  * @return The number of operands if the mnemonic is found, -1 otherwise.
  */
 int get_operand_count(const char *mnemonic) {
-    for (size_t i = 0; i < sizeof(opcode_table) / sizeof(opcode_table[0]); i++) {
-        if (strcmp(opcode_table[i].mnemonic, mnemonic) == 0) {
-            return opcode_table[i].operands;
-        }
+    int opcode = get_opcode(mnemonic);
+    if (opcode == -1) {
+        return -1;
     }
-    return -1;  
+    return opcode_table[opcode].operands;
+}
+/**
+ * Returns the opcode table entry of an opcode. The table is ordered by opcode, so it is indexed directly.
+ * @param opcode The opcode to look up.
+ * @return Pointer to the entry if the opcode is defined, NULL otherwise.
+ */
+const OpcodeEntry *get_opcode_entry(int opcode) {
+    if (opcode < 0 || opcode >= OPCODE_COUNT || opcode_table[opcode].mnemonic[0] == '\0') {
+        return NULL;
+    }
+    return &opcode_table[opcode];
+}
+
+/**
+ * Returns the mnemonic of an opcode.
+ * @param opcode The opcode to look up.
+ * @return The mnemonic if the opcode is defined, NULL otherwise.
+ */
+const char *get_mnemonic(int opcode) {
+    const OpcodeEntry *entry = get_opcode_entry(opcode);
+    return entry ? entry->mnemonic : NULL;
+}
+
+/**
+ * Looks up a mnemonic and returns what the instruction does to its operands and control flow.
+ * @param mnemonic The instruction mnemonic to look up.
+ * @return The bitmask of EFFECT_* flags if the mnemonic is found, 0 otherwise.
+ */
+int get_effects(const char *mnemonic) {
+    int opcode = get_opcode(mnemonic);
+    if (opcode == -1) {
+        return 0;
+    }
+    return opcode_table[opcode].effects;
 }
@@ -0,0 +1,695 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "optimizer.h"
+#include "utilities.h"
+#include "opcode_table.h"
+#include "error_handling.h"
+#include "expression.h"
+
+#define REMOVED_LINE "; removed by -O1\n"
+#define MERGED_LINE "; merged by --pool-data\n"
+
+/**
+ * @brief One line of the expanded source file, with its parsed parts.
+ */
+typedef struct {
+    char *text;                           /* The line as it will be written back */
+    char label[MAX_LABEL_LENGTH + 1];     /* Label of the statement, or "" */
+    char operation[MAX_LABEL_LENGTH + 1]; /* Operation or directive, or "" for empty lines */
+    char operands[MAX_LINE_LENGTH + 1];   /* Operands of the statement */
+    int run;                              /* Index of the data run the line belongs to, or -1 */
+    int first_word;                       /* Offset of the directive's words in its run */
+    int word_count;                       /* Number of data words of the directive */
+} SourceLine;
+
+/**
+ * @brief The lines of an expanded source file.
+ */
+typedef struct {
+    SourceLine *lines;
+    int count;
+    int capacity;
+} SourceFile;
+
+/**
+ * @brief A labeled data directive and the unlabeled data directives that follow it in the data image.
+ */
+typedef struct {
+    const char *label;     /* Label of the run, or "" for data before the first data label */
+    unsigned short *words; /* The data words of the run */
+    int length;
+    int capacity;
+    bool pinned;           /* The label is pinned, see is_label_pinned() */
+    bool safe;             /* The run is not pinned and all its values are plain numbers */
+    bool merged;           /* The run was merged into an identical earlier one */
+} DataRun;
+
+/**
+ * Parses a line into label, operation, and operands as the first pass does.
+ * @param line Pointer to the line; its text must already be set.
+ */
+static void parse_source_line(SourceLine *line) {
+    char work[MAX_LINE_LENGTH + 1];
+    line->label[0] = '\0';
+    line->operation[0] = '\0';
+    line->operands[0] = '\0';
+    line->run = -1;
+    line->first_word = 0;
+    line->word_count = 0;
+    strncpy(work, line->text, MAX_LINE_LENGTH);
+    work[MAX_LINE_LENGTH] = '\0';
+    handle_comment(work);
+    handle_extra_spaces(work);
+    trim(work);
+    if (work[0] == '\0') return;
+
+    char *token = strtok(work, " \t\n");
+    if (token != NULL && token[strlen(token) - 1] == ':') {
+        token[strlen(token) - 1] = '\0';
+        strncpy(line->label, token, MAX_LABEL_LENGTH);
+        line->label[MAX_LABEL_LENGTH] = '\0';
+        token = strtok(NULL, " \t");
+    }
+    if (token == NULL) return;
+    strncpy(line->operation, token, MAX_LABEL_LENGTH);
+    line->operation[MAX_LABEL_LENGTH] = '\0';
+    token = strtok(NULL, "\n");
+    if (token != NULL) {
+        strncpy(line->operands, token, MAX_LINE_LENGTH);
+        line->operands[MAX_LINE_LENGTH] = '\0';
+        trim(line->operands);
+    }
+}
+
+/**
+ * Reads and parses the expanded source file, in the same chunks the passes read it.
+ * @param filename The name of the expanded (.am) file.
+ * @param source Pointer to the source file to fill.
+ * @return true if the file was read successfully, false otherwise.
+ */
+static bool read_source_file(const char *filename, SourceFile *source) {
+    source->lines = NULL;
+    source->count = 0;
+    source->capacity = 0;
+
+    FILE *file = fopen(filename, "r");
+    if (!file) {
+        log_error(ERR_FILE_INPUT, "Failed to open file for optimization", filename, 0);
+        return false;
+    }
+
+    char line[MAX_LINE_LENGTH + 1];
+    bool ok = true;
+    while (fgets(line, sizeof(line), file)) {
+        if (source->count == source->capacity) {
+            int new_capacity = source->capacity == 0 ? 64 : source->capacity * 2;
+            SourceLine *new_lines = realloc(source->lines, new_capacity * sizeof(SourceLine));
+            if (!new_lines) {
+                log_error(ERR_MEMORY, "Failed to allocate memory for optimizer lines", filename, source->count);
+                ok = false;
+                break;
+            }
+            source->lines = new_lines;
+            source->capacity = new_capacity;
+        }
+        SourceLine *source_line = &source->lines[source->count];
+        source_line->text = strdup(line);
+        if (!source_line->text) {
+            log_error(ERR_MEMORY, "Failed to allocate memory for optimizer lines", filename, source->count);
+            ok = false;
+            break;
+        }
+        parse_source_line(source_line);
+        source->count++;
+    }
+    fclose(file);
+    return ok;
+}
+
+/**
+ * Writes the source file back, one line per line read, so line numbers stay valid.
+ * @param filename The name of the expanded (.am) file.
+ * @param source Pointer to the source file.
+ * @return true if the file was written successfully, false otherwise.
+ */
+static bool write_source_file(const char *filename, const SourceFile *source) {
+    FILE *file = fopen(filename, "w");
+    if (!file) {
+        log_error(ERR_FILE_OUTPUT, "Failed to write optimized file", filename, 0);
+        return false;
+    }
+    for (int i = 0; i < source->count; i++) {
+        fputs(source->lines[i].text, file);
+    }
+    fclose(file);
+    return true;
+}
+
+/**
+ * Frees the lines of a source file.
+ * @param source Pointer to the source file.
+ */
+static void free_source_file(SourceFile *source) {
+    for (int i = 0; i < source->count; i++) {
+        free(source->lines[i].text);
+    }
+    free(source->lines);
+    source->lines = NULL;
+    source->count = 0;
+    source->capacity = 0;
+}
+
+/**
+ * Replaces the text of a line. The parsed parts are left as they were.
+ * @param line Pointer to the line.
+ * @param text The new text, ending with a newline.
+ * @return true if the text was replaced, false if memory allocation failed.
+ */
+static bool replace_line(SourceLine *line, const char *text) {
+    char *new_text = strdup(text);
+    if (!new_text) {
+        return false;
+    }
+    free(line->text);
+    line->text = new_text;
+    return true;
+}
+
+/**
+ * Checks if an instruction is the named one and the instruction set describes it with the
+ * expected effects. The peephole rules match instructions by name, so this keeps them from
+ * firing on a variant instruction set that gives the name a different meaning.
+ * @param operation The operation part of the instruction.
+ * @param mnemonic The mnemonic the rule matches.
+ * @param effects The EFFECT_* flags the rule relies on.
+ * @return true if the rule applies to the instruction, false otherwise.
+ */
+static bool is_instruction(const char *operation, const char *mnemonic, int effects) {
+    return strcmp(operation, mnemonic) == 0 && get_effects(mnemonic) == effects;
+}
+
+/**
+ * Decides how to rewrite one instruction. Unlabeled instructions that do nothing are removed:
+ * mov rX, rX, add #0 and sub #0, and a jmp to the address right after it. mov #0 is replaced
+ * by the one word shorter clr, keeping its label.
+ * @param label The label of the instruction, or an empty string.
+ * @param operation The operation part of the instruction.
+ * @param operands The operands part of the instruction.
+ * @param address The address of the instruction.
+ * @param length The length of the instruction in words.
+ * @param symbol_table Pointer to the symbol table.
+ * @param replacement Buffer of MAX_LINE_LENGTH + 2 characters for the new line; left empty to remove the line.
+ * @return true if the instruction should be rewritten, false if it stays as it is.
+ */
+static bool rewrite_instruction(const char *label, const char *operation, const char *operands, int address,
+                                int length, SymbolTable *symbol_table, char *replacement) {
+    char source[MAX_LINE_LENGTH + 1];
+    char target[MAX_LINE_LENGTH + 1];
+    split_operands(operands, source, target);
+    int source_mode = get_addressing_mode(source);
+    int target_mode = get_addressing_mode(target);
+    bool source_is_zero = source_mode == 0 && is_number(source) && atoi(source + 1) == 0;
+    replacement[0] = '\0';
+
+    /* mov #0, X becomes clr X */
+    if (is_instruction(operation, "mov", EFFECT_READS_SOURCE | EFFECT_WRITES_TARGET) && source_is_zero &&
+        get_effects("clr") == EFFECT_WRITES_TARGET && is_legal_addressing("clr", target)) {
+        int written;
+        if (label[0] != '\0') {
+            written = snprintf(replacement, MAX_LINE_LENGTH + 2, "%s: clr %s\n", label, target);
+        } else {
+            written = snprintf(replacement, MAX_LINE_LENGTH + 2, "clr %s\n", target);
+        }
+        return written < MAX_LINE_LENGTH + 2;
+    }
+
+    /* Removing a labeled instruction would leave its label without a line */
+    if (label[0] != '\0') {
+        return false;
+    }
+
+    /* mov rX, rX */
+    if (is_instruction(operation, "mov", EFFECT_READS_SOURCE | EFFECT_WRITES_TARGET) && source_mode == 3 && target_mode == 3 && strcmp(source, target) == 0) {
+        return true;
+    }
+    /* add #0, X and sub #0, X */
+    int arithmetic = EFFECT_READS_SOURCE | EFFECT_READS_TARGET | EFFECT_WRITES_TARGET;
+    if ((is_instruction(operation, "add", arithmetic) || is_instruction(operation, "sub", arithmetic)) &&
+        source_is_zero) {
+        return true;
+    }
+    /* jmp to the next instruction */
+    if (is_instruction(operation, "jmp", EFFECT_ENDS_FLOW) && target_mode == 1) {
+        Symbol *symbol = find_symbol(symbol_table, target);
+        if (symbol && symbol->type == SYMBOL_TYPE_CODE && symbol->address == address + length) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Checks if execution never continues to the instruction after this one.
+ * @param operation The operation part of the instruction.
+ * @return true if the instruction set marks the instruction with EFFECT_ENDS_FLOW, false otherwise.
+ */
+static bool ends_control_flow(const char *operation) {
+    return (get_effects(operation) & EFFECT_ENDS_FLOW) != 0;
+}
+
+/**
+ * Checks if any instruction addresses memory through an expression such as LABEL+3.
+ * Such an address points a fixed number of words past its label, so removing or
+ * shortening an instruction in between would silently move its target.
+ * @param source Pointer to the source file.
+ * @return true if an operand is an address expression, false otherwise.
+ */
+static bool uses_address_expressions(const SourceFile *source) {
+    for (int i = 0; i < source->count; i++) {
+        const SourceLine *line = &source->lines[i];
+        if (get_opcode(line->operation) == -1) continue;
+
+        char operand_source[MAX_LINE_LENGTH + 1];
+        char operand_target[MAX_LINE_LENGTH + 1];
+        split_operands(line->operands, operand_source, operand_target);
+        if ((get_addressing_mode(operand_source) == 1 && is_expression(operand_source)) ||
+            (get_addressing_mode(operand_target) == 1 && is_expression(operand_target))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Runs the optimizer over the expanded source file. Addresses are computed the same way as in
+ * the first pass, so jumps are compared against the addresses in the symbol table.
+ * Instructions after stop, rts or jmp are unreachable until the next labeled instruction and
+ * are removed. Every label counts as a possible target, since lea and .entry can take the
+ * address of any label and jmp *rX can jump to it.
+ * Removing one instruction can expose another (for example a jmp that now lands on the next
+ * instruction), so the caller repeats the first pass and the optimizer until nothing changes.
+ * Every rewrite changes code length, so a file with address expressions is left as it is.
+ * @param filename The name of the expanded (.am) file.
+ * @param symbol_table Pointer to the symbol table built by the first pass.
+ * @return true if the file was changed and addresses must be recomputed, false otherwise.
+ */
+bool optimize_code(const char *filename, SymbolTable *symbol_table) {
+    SourceFile source;
+    if (!read_source_file(filename, &source)) {
+        free_source_file(&source);
+        return false;
+    }
+
+    if (uses_address_expressions(&source)) {
+        free_source_file(&source);
+        return false;
+    }
+
+    bool changed = false;
+    bool reachable = true;
+    int IC = FIRST_ADDRESS;
+    for (int i = 0; i < source.count; i++) {
+        SourceLine *line = &source.lines[i];
+
+        /* Only instructions occupy code addresses */
+        if (get_opcode(line->operation) == -1) continue;
+        int length = get_instruction_length(line->operation, line->operands);
+        if (length == -1) continue;
+
+        /* Any label may be a jump target, so a labeled instruction starts reachable code again */
+        if (line->label[0] != '\0') {
+            reachable = true;
+        }
+
+        char replacement[MAX_LINE_LENGTH + 2];
+        replacement[0] = '\0';
+        if (!reachable || rewrite_instruction(line->label, line->operation, line->operands, IC, length,
+                                              symbol_table, replacement)) {
+            if (replace_line(line, replacement[0] != '\0' ? replacement : REMOVED_LINE)) {
+                changed = true;
+            }
+        }
+        if (ends_control_flow(line->operation)) {
+            reachable = false;
+        }
+        IC += length;
+    }
+
+    if (changed && !write_source_file(filename, &source)) {
+        changed = false;
+    }
+    free_source_file(&source);
+    return changed;
+}
+
+/**
+ * Checks if an instruction stores a value in its target operand.
+ * @param operation The operation part of the instruction.
+ * @return true if the target is written, false if it is only read.
+ */
+static bool writes_target(const char *operation) {
+    return (get_effects(operation) & EFFECT_WRITES_TARGET) != 0;
+}
+
+/**
+ * Checks if an instruction uses its source operand as an address rather than a value,
+ * as lea does.
+ * @param operation The operation part of the instruction.
+ * @return true if the source is present but neither read nor written, false otherwise.
+ */
+static bool takes_source_address(const char *operation) {
+    const OpcodeEntry *entry = get_opcode_entry(get_opcode(operation));
+    return entry && entry->source_modes != NO_OPERAND && !(entry->effects & EFFECT_READS_SOURCE);
+}
+
+/**
+ * Checks if a constant expression uses a label.
+ * @param text The operand or data values to search.
+ * @param label The label to look for.
+ * @return true if the label appears as a whole name in the text, false otherwise.
+ */
+static bool mentions_label(const char *text, const char *label) {
+    size_t length = strlen(label);
+    for (const char *p = strstr(text, label); p != NULL; p = strstr(p + 1, label)) {
+        bool starts_name = p == text || !isalnum((unsigned char)p[-1]);
+        bool ends_name = !isalnum((unsigned char)p[length]);
+        if (starts_name && ends_name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Checks if a data label may be changed at run time, seen from outside the file, or
+ * used for more than its own address. That is the case when an instruction writes to
+ * it, lea takes its address (it can then be written through a register), it is
+ * declared with .entry, or a constant expression such as LABEL+3 uses it.
+ * @param source Pointer to the source file.
+ * @param label The label to check.
+ * @return true if the data behind the label must keep its own copy, false otherwise.
+ */
+static bool is_label_pinned(const SourceFile *source, const char *label) {
+    for (int i = 0; i < source->count; i++) {
+        const SourceLine *line = &source->lines[i];
+        if (strcmp(line->operation, ".entry") == 0 && strcmp(line->operands, label) == 0) {
+            return true;
+        }
+        if (strcmp(line->operation, ".data") == 0 && mentions_label(line->operands, label)) {
+            return true;
+        }
+        if (get_opcode(line->operation) == -1) continue;
+
+        char operand_source[MAX_LINE_LENGTH + 1];
+        char operand_target[MAX_LINE_LENGTH + 1];
+        split_operands(line->operands, operand_source, operand_target);
+        if (takes_source_address(line->operation) && strcmp(operand_source, label) == 0) {
+            return true;
+        }
+        if (writes_target(line->operation) && strcmp(operand_target, label) == 0) {
+            return true;
+        }
+        if ((strcmp(operand_source, label) != 0 && mentions_label(operand_source, label)) ||
+            (strcmp(operand_target, label) != 0 && mentions_label(operand_target, label))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Checks if the values of a .data directive include a label or constant expression.
+ * @param operands The operands of the directive.
+ * @return true if any value is not a plain number, false otherwise.
+ */
+static bool has_symbolic_values(const char *operands) {
+    char values[MAX_LINE_LENGTH + 1];
+    strcpy(values, operands);
+    for (char *token = strtok(values, ","); token != NULL; token = strtok(NULL, ",")) {
+        trim(token);
+        if (!is_number(token)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Adds a word to a data run, growing its word array as needed.
+ * @param run Pointer to the run.
+ * @param word The data word.
+ * @return true if the word was added, false if memory allocation failed.
+ */
+static bool add_run_word(DataRun *run, unsigned short word) {
+    if (run->length == run->capacity) {
+        int new_capacity = run->capacity == 0 ? 16 : run->capacity * 2;
+        unsigned short *new_words = realloc(run->words, new_capacity * sizeof(unsigned short));
+        if (!new_words) {
+            return false;
+        }
+        run->words = new_words;
+        run->capacity = new_capacity;
+    }
+    run->words[run->length++] = word;
+    return true;
+}
+
+/**
+ * Adds the words of a .data or .string directive to a data run, encoded as write_data()
+ * and write_string() encode them, so runs are compared word for word.
+ * @param run Pointer to the run.
+ * @param line Pointer to the directive line.
+ * @return true if the words were added, false if memory allocation failed.
+ */
+static bool add_directive_words(DataRun *run, const SourceLine *line) {
+    bool ok = true;
+    if (strcmp(line->operation, ".data") == 0) {
+        char values[MAX_LINE_LENGTH + 1];
+        strcpy(values, line->operands);
+        for (char *token = strtok(values, ","); token != NULL && ok; token = strtok(NULL, ",")) {
+            ok = add_run_word(run, (unsigned short)atoi(token) & 0x7FFF);
+        }
+    } else {
+        for (const char *str = line->operands + 1; *str != '"' && *str != '\0' && ok; str++) {
+            ok = add_run_word(run, (unsigned char)*str);
+        }
+        ok = ok && add_run_word(run, 0);
+    }
+    return ok;
+}
+
+/**
+ * Builds the operands of an instruction with every direct reference to one label
+ * replaced by another.
+ * @param line Pointer to the instruction line.
+ * @param from The label to replace.
+ * @param to The label to use instead.
+ * @param operands Buffer of MAX_LINE_LENGTH + 1 characters for the new operands.
+ * @return true if the rebuilt line fits in MAX_LINE_LENGTH, false otherwise.
+ */
+static bool rename_operands(const SourceLine *line, const char *from, const char *to, char *operands) {
+    char operand_source[MAX_LINE_LENGTH + 1];
+    char operand_target[MAX_LINE_LENGTH + 1];
+    split_operands(line->operands, operand_source, operand_target);
+    if (strcmp(operand_source, from) == 0) strcpy(operand_source, to);
+    if (strcmp(operand_target, from) == 0) strcpy(operand_target, to);
+
+    int written;
+    if (operand_source[0] != '\0') {
+        written = snprintf(operands, MAX_LINE_LENGTH + 1, "%s, %s", operand_source, operand_target);
+    } else {
+        written = snprintf(operands, MAX_LINE_LENGTH + 1, "%s", operand_target);
+    }
+    /* label, ": ", operation, " ", operands; written counts operands that did not fit */
+    size_t length = strlen(line->operation) + 1 + (size_t)written;
+    if (line->label[0] != '\0') {
+        length += strlen(line->label) + 2;
+    }
+    return length <= MAX_LINE_LENGTH;
+}
+
+/**
+ * Replaces every direct reference to one label by another in the instructions of the file.
+ * @param source Pointer to the source file.
+ * @param from The label to replace.
+ * @param to The label to use instead.
+ * @param apply false to only check that every rewritten line fits, true to rewrite the lines.
+ * @return true if every rewritten line fits (and, when applying, was rewritten), false otherwise.
+ */
+static bool rename_label(SourceFile *source, const char *from, const char *to, bool apply) {
+    for (int i = 0; i < source->count; i++) {
+        SourceLine *line = &source->lines[i];
+        if (get_opcode(line->operation) == -1) continue;
+
+        char operand_source[MAX_LINE_LENGTH + 1];
+        char operand_target[MAX_LINE_LENGTH + 1];
+        split_operands(line->operands, operand_source, operand_target);
+        if (strcmp(operand_source, from) != 0 && strcmp(operand_target, from) != 0) continue;
+
+        char operands[MAX_LINE_LENGTH + 1];
+        if (!rename_operands(line, from, to, operands)) {
+            return false;
+        }
+        if (apply) {
+            /* rename_operands() checked that the line fits; the buffer is sized for the compiler */
+            char text[2 * MAX_LABEL_LENGTH + MAX_LINE_LENGTH + 6];
+            if (line->label[0] != '\0') {
+                snprintf(text, sizeof(text), "%s: %s %s\n", line->label, line->operation, operands);
+            } else {
+                snprintf(text, sizeof(text), "%s %s\n", line->operation, operands);
+            }
+            if (!replace_line(line, text)) {
+                return false;
+            }
+            strcpy(line->operands, operands);
+        }
+    }
+    return true;
+}
+
+/**
+ * Checks if a data directive has plain number values, so its words are final.
+ * @param line Pointer to the directive line.
+ * @return true if the words of the directive are known before addresses are, false otherwise.
+ */
+static bool has_final_words(const SourceLine *line) {
+    return strcmp(line->operation, ".string") == 0 || !has_symbolic_values(line->operands);
+}
+
+/**
+ * Removes unlabeled data directives whose words already appear as an earlier directive.
+ * Only the label of a run addresses its data, and a run that is not pinned is only read
+ * at its first word, so its unlabeled directives cannot be reached and one copy is enough.
+ * @param source Pointer to the source file, with the runs of its directives set.
+ * @param runs The data runs of the file.
+ * @return true if a directive was removed, false otherwise.
+ */
+static bool pool_unlabeled_directives(SourceFile *source, const DataRun *runs) {
+    bool changed = false;
+    for (int j = 0; j < source->count; j++) {
+        SourceLine *line = &source->lines[j];
+        if (line->run == -1 || line->label[0] != '\0' || runs[line->run].pinned || runs[line->run].merged ||
+            !has_final_words(line)) {
+            continue;
+        }
+        const unsigned short *words = runs[line->run].words + line->first_word;
+        for (int i = 0; i < j; i++) {
+            const SourceLine *kept = &source->lines[i];
+            if (kept->run == -1 || runs[kept->run].merged || kept->word_count != line->word_count ||
+                !has_final_words(kept)) {
+                continue;
+            }
+            const unsigned short *kept_words = runs[kept->run].words + kept->first_word;
+            if (memcmp(kept_words, words, line->word_count * sizeof(unsigned short)) != 0) {
+                continue;
+            }
+            replace_line(line, MERGED_LINE);
+            line->run = -1;
+            changed = true;
+            break;
+        }
+    }
+    return changed;
+}
+
+/**
+ * Merges identical data runs in the expanded source file. A run is a labeled .data or
+ * .string directive together with the unlabeled data directives after it, since those
+ * are laid out right after it and may be reached from its label. A run is merged into an
+ * earlier run with the same words when neither is pinned (see is_label_pinned());
+ * references to the label of the merged run are renamed to the
+ * label of the kept run, and its directives become comment lines. Unlabeled directives
+ * repeated elsewhere in the data image are then removed, see pool_unlabeled_directives().
+ * @param filename The name of the expanded (.am) file.
+ * @return true if the file was changed and addresses must be recomputed, false otherwise.
+ */
+bool pool_data_blocks(const char *filename) {
+    SourceFile source;
+    if (!read_source_file(filename, &source)) {
+        free_source_file(&source);
+        return false;
+    }
+
+    DataRun *runs = NULL;
+    int run_count = 0;
+    bool error = false;
+
+    /* Split the data image into runs */
+    for (int i = 0; i < source.count && !error; i++) {
+        SourceLine *line = &source.lines[i];
+        if (strcmp(line->operation, ".data") != 0 && strcmp(line->operation, ".string") != 0) continue;
+
+        if (run_count == 0 || line->label[0] != '\0') {
+            DataRun *new_runs = realloc(runs, (run_count + 1) * sizeof(DataRun));
+            if (!new_runs) {
+                error = true;
+                break;
+            }
+            runs = new_runs;
+            DataRun *run = &runs[run_count++];
+            run->label = line->label;
+            run->words = NULL;
+            run->length = 0;
+            run->capacity = 0;
+            run->pinned = line->label[0] != '\0' && is_label_pinned(&source, line->label);
+            run->safe = !run->pinned;
+            run->merged = false;
+        }
+        line->run = run_count - 1;
+        /* Values that depend on labels are only known once addresses are final */
+        if (strcmp(line->operation, ".data") == 0 && has_symbolic_values(line->operands)) {
+            runs[run_count - 1].safe = false;
+        }
+        line->first_word = runs[run_count - 1].length;
+        error = !add_directive_words(&runs[run_count - 1], line);
+        line->word_count = runs[run_count - 1].length - line->first_word;
+    }
+    if (error) {
+        log_error(ERR_MEMORY, "Failed to allocate memory for data runs", filename, 0);
+    }
+
+    /* Merge each safe run into the first identical safe run before it */
+    bool changed = false;
+    for (int j = 0; j < run_count && !error; j++) {
+        DataRun *run = &runs[j];
+        if (!run->safe) continue;
+        for (int i = 0; i < j; i++) {
+            DataRun *kept = &runs[i];
+            if (kept->merged || !kept->safe || kept->length != run->length ||
+                memcmp(kept->words, run->words, run->length * sizeof(unsigned short)) != 0) {
+                continue;
+            }
+            if (run->label[0] != '\0') {
+                /* References need a label to point to */
+                if (kept->label[0] == '\0' || !rename_label(&source, run->label, kept->label, false)) {
+                    continue;
+                }
+                rename_label(&source, run->label, kept->label, true);
+            }
+            for (int k = 0; k < source.count; k++) {
+                if (source.lines[k].run == j) {
+                    replace_line(&source.lines[k], MERGED_LINE);
+                }
+            }
+            run->merged = true;
+            changed = true;
+            break;
+        }
+    }
+
+    if (!error && pool_unlabeled_directives(&source, runs)) {
+        changed = true;
+    }
+
+    if (changed && !error && !write_source_file(filename, &source)) {
+        changed = false;
+    }
+    for (int i = 0; i < run_count; i++) {
+        free(runs[i].words);
+    }
+    free(runs);
+    free_source_file(&source);
+    return changed && !error;
+}
@@ -0,0 +1,54 @@
+#include <string.h>
+#include "options.h"
+
+AssemblerOptions assembler_options = {0};
+
+/**
+ * Checks if a command-line argument is an option. File names never start with '-'.
+ * @param arg The argument to check.
+ * @return true if the argument is an option, false otherwise.
+ */
+bool is_option(const char *arg) {
+    return arg[0] == '-' && arg[1] != '\0';
+}
+
+/**
+ * Applies a single command-line option to the global assembler options.
+ * @param arg The option to apply, including its leading dashes.
+ * @return true if the option was recognized, false otherwise.
+ */
+bool parse_option(const char *arg) {
+    if (strcmp(arg, "--line-map") == 0) {
+        assembler_options.emit_line_map = true;
+        return true;
+    }
+    if (strcmp(arg, "--cost-report") == 0) {
+        assembler_options.cost_report = true;
+        return true;
+    }
+    if (strcmp(arg, "--verify") == 0) {
+        assembler_options.verify = true;
+        return true;
+    }
+    if (strcmp(arg, "--pool-data") == 0) {
+        assembler_options.pool_data = true;
+        return true;
+    }
+    if (strcmp(arg, "--time-report") == 0) {
+        assembler_options.time_report = true;
+        return true;
+    }
+    if (strcmp(arg, "--memory-report") == 0) {
+        assembler_options.memory_report = true;
+        return true;
+    }
+    if (strcmp(arg, "-O1") == 0) {
+        assembler_options.optimize = true;
+        return true;
+    }
+    if (strcmp(arg, "-O0") == 0) {
+        assembler_options.optimize = false;
+        return true;
+    }
+    return false;
+}
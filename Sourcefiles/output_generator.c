@@ -9,8 +9,9 @@
  * @param symbol_table Pointer to the symbol table containing all symbols and their information.
  * @param IC The final Instruction Counter value.
  * @param DC The final Data Counter value.
+ * @param line_map Pointer to the address-to-source line map, or NULL if no .lin file was requested.
  */
-void generate_output(const char *input_filename, SymbolTable *symbol_table, int IC, int DC) {
+void generate_output(const char *input_filename, SymbolTable *symbol_table, int IC, int DC, const LineMap *line_map) {
     char base_name[MEMORY_SIZE];
     strncpy(base_name, input_filename, sizeof(base_name));
     
@@ -30,6 +31,11 @@ void generate_output(const char *input_filename, SymbolTable *symbol_table, int
     if (symbol_table->has_externs) {
         generate_ext_file(base_name, symbol_table);
     }
+
+    /* Generate the line map file if it was requested */
+    if (line_map != NULL) {
+        generate_lin_file(base_name, line_map);
+    }
 }
 
 /**
@@ -42,7 +48,7 @@ void generate_output(const char *input_filename, SymbolTable *symbol_table, int
 void generate_ob_file(const char *base_name, SymbolTable *symbol_table, int IC, int DC) {
     char temp_filename[MEMORY_SIZE];
     char ob_filename[MEMORY_SIZE];
-    snprintf(temp_filename, sizeof(temp_filename), "temp.ob");
+    snprintf(temp_filename, sizeof(temp_filename), "%s.ob.tmp", base_name);
     snprintf(ob_filename, sizeof(ob_filename), "%s.ob", base_name);
     
     FILE *temp_file = fopen(temp_filename, "r");
@@ -118,3 +124,29 @@ void generate_ext_file(const char *base_name, SymbolTable *symbol_table) {
 
     fclose(file);
 }
+
+/**
+ * Generates the line map (.lin) file. Each line holds one address range and the source line
+ * it came from: "start end line expansion", where expansion is the line of the macro call
+ * that produced the range, or 0 if the line was not part of a macro expansion.
+ * @param base_name The base name for the output file (without extension).
+ * @param line_map Pointer to the address-to-source line map.
+ */
+void generate_lin_file(const char *base_name, const LineMap *line_map) {
+    char filename[MEMORY_SIZE];
+    snprintf(filename, sizeof(filename), "%s.lin", base_name);
+    FILE *file = fopen(filename, "w");
+    if (!file) {
+        log_error(ERR_FILE_OUTPUT, "Failed to create .lin file", filename, 0);
+        return;
+    }
+
+    /* Ranges are already sorted by address, so they can be binary searched once loaded */
+    for (int i = 0; i < line_map->count; i++) {
+        const LineRange *range = &line_map->ranges[i];
+        fprintf(file, "%04d %04d %d %d\n", range->start_address, range->end_address,
+                range->source_line, range->expansion_line);
+    }
+
+    fclose(file);
+}
@@ -6,7 +6,9 @@
 #include "opcode_table.h"
 #include "utilities.h"
 #include "error_handling.h"
+#include "alloc_stats.h"
 
+LineOriginTable line_origins;
 
 /**
  * Initializes the macro table by setting its count and capacity to 0 and its macros pointer to NULL.
@@ -17,6 +19,44 @@ void init_macro_table() {
     macro_table.capacity = 0;
 }
 
+/**
+ * Initializes the line origin table by setting its count and capacity to 0 and its origins pointer to NULL.
+ */
+void init_line_origins() {
+    line_origins.origins = NULL;
+    line_origins.count = 0;
+    line_origins.capacity = 0;
+}
+
+/**
+ * Appends the origin of the next line written to the expanded file, growing the table if necessary.
+ * @param source_line The line number in the original .as file.
+ * @param expansion_line The line of the macro call that produced the line, or 0 for ordinary lines.
+ */
+void add_line_origin(int source_line, int expansion_line) {
+    if (line_origins.count == line_origins.capacity) {
+        int new_capacity = line_origins.capacity == 0 ? 64 : line_origins.capacity * 2;
+        LineOrigin *new_origins = counted_realloc(line_origins.origins, new_capacity * sizeof(LineOrigin));
+        if (!new_origins) {
+            log_error(ERR_MEMORY, "Failed to allocate memory for line origins", "pre_assembler", source_line);
+            return;
+        }
+        line_origins.origins = new_origins;
+        line_origins.capacity = new_capacity;
+    }
+    line_origins.origins[line_origins.count].source_line = source_line;
+    line_origins.origins[line_origins.count].expansion_line = expansion_line;
+    line_origins.count++;
+}
+
+/**
+ * Frees the memory allocated for the line origin table and resets it to an empty state.
+ */
+void free_line_origins() {
+    counted_free(line_origins.origins);
+    init_line_origins();
+}
+
 /**
  * Adds a new macro to the macro table. It expands the table if necessary, allocates memory for the new macro,
  * and stores its name and content.
@@ -29,7 +69,7 @@ void add_macro(const char *name, FILE *file, int *line_number, const char *filen
     /* Expand macro table if necessary */
     if (macro_table.count == macro_table.capacity) {
         int new_capacity = macro_table.capacity == 0 ? 1 : macro_table.capacity * 2;
-        Macro *new_macros = realloc(macro_table.macros, new_capacity * sizeof(Macro));
+        Macro *new_macros = counted_realloc(macro_table.macros, new_capacity * sizeof(Macro));
         if (!new_macros) {
             log_error(ERR_MEMORY, "Failed to allocate memory for macro table", filename, *line_number);
             return;
@@ -40,10 +80,11 @@ void add_macro(const char *name, FILE *file, int *line_number, const char *filen
 
     /* Initialize new macro */
     Macro *macro = &macro_table.macros[macro_table.count++];
-    macro->name = strdup(name);
+    macro->name = counted_strdup(name);
     macro->lines = NULL;
     macro->line_count = 0;
     macro->line_capacity = 0;
+    macro->first_line = *line_number + 1;
 
     char line[MAX_LINE_LENGTH + 1];
     /* Read macro content until 'endmacr' is encountered */
@@ -63,7 +104,7 @@ void add_macro(const char *name, FILE *file, int *line_number, const char *filen
         /* Expand macro lines array if necessary */
         if (macro->line_count == macro->line_capacity) {
             int new_capacity = macro->line_capacity == 0 ? 1 : macro->line_capacity * 2;
-            char **new_lines = realloc(macro->lines, new_capacity * sizeof(char*));
+            char **new_lines = counted_realloc(macro->lines, new_capacity * sizeof(char*));
             if (!new_lines) {
                 log_error(ERR_MEMORY, "Failed to allocate memory for macro lines", filename, *line_number);
                 return;
@@ -71,7 +112,7 @@ void add_macro(const char *name, FILE *file, int *line_number, const char *filen
             macro->lines = new_lines;
             macro->line_capacity = new_capacity;
         }
-        macro->lines[macro->line_count++] = strdup(line);
+        macro->lines[macro->line_count++] = counted_strdup(line);
     }
 }
 
@@ -80,13 +121,14 @@ void add_macro(const char *name, FILE *file, int *line_number, const char *filen
  */
 void free_macro_table() {
     for (int i = 0; i < macro_table.count; i++) {
-        free(macro_table.macros[i].name);
+        counted_free(macro_table.macros[i].name);
         for (int j = 0; j < macro_table.macros[i].line_count; j++) {
-            free(macro_table.macros[i].lines[j]);
+            counted_free(macro_table.macros[i].lines[j]);
         }
-        free(macro_table.macros[i].lines);
+        counted_free(macro_table.macros[i].lines);
     }
-    free(macro_table.macros);
+    counted_free(macro_table.macros);
+    init_macro_table(); /* The first pass may run again after optimization */
 }
 
 /**
@@ -149,7 +191,7 @@ void expand_macro(const char *name, FILE *output) {
 char *pre_assembler(const char *input_filename) {
     size_t len = strlen(input_filename);
     /* Allocate memory for the expanded filename */
-    char *expanded_filename = malloc(strlen(input_filename) + 4);
+    char *expanded_filename = counted_malloc(strlen(input_filename) + 4);
     if (!expanded_filename) {
         log_error(ERR_MEMORY, "Failed to allocate memory for expanded filename", input_filename, 0);
         return NULL;
@@ -166,11 +208,12 @@ char *pre_assembler(const char *input_filename) {
 
     if (!input || !output) {
         log_error(ERR_FILE_INPUT, "Failed to open input or output file", input_filename, 0);
-        free(expanded_filename);
+        counted_free(expanded_filename);
         return NULL;
     }
 
     init_macro_table();
+    init_line_origins();
 
     char line[MAX_LINE_LENGTH + 1];
     char macro_name[MAX_MACRO_NAME + 1];
@@ -213,6 +256,10 @@ char *pre_assembler(const char *input_filename) {
         for (int i = 0; i < macro_table.count; i++) {
             if (strcmp(trimmed_line, macro_table.macros[i].name) == 0) {
                 expand_macro(macro_table.macros[i].name, output);
+                /* Each expanded line comes from the macro body, expanded at this line */
+                for (int j = 0; j < macro_table.macros[i].line_count; j++) {
+                    add_line_origin(macro_table.macros[i].first_line + j, line_number);
+                }
                 is_macro = 1;
                 break;
             }
@@ -221,6 +268,7 @@ char *pre_assembler(const char *input_filename) {
         /* Write non-macro lines to output */
         if (!is_macro) {
             fputs(line, output);
+            add_line_origin(line_number, 0);
        }
     }
 
@@ -0,0 +1,380 @@
+/**
+ * Benchmark Runner
+ *
+ * Purpose:
+ * Measures assembler throughput on a fixed set of generated workloads and
+ * compares it with a stored baseline, so performance regressions show up
+ * before they are released.
+ *
+ * For each workload, the runner generates its input with gen_workload, runs
+ * ./assembler --time-report on it BENCH_RUNS times and keeps the best lines of
+ * source per second of CPU time of each phase. CPU time leaves out time spent
+ * waiting for other processes, and the best run is the one least disturbed by
+ * them, so the result is far steadier than a median of wall time. A phase is
+ * flagged as a regression when its best run is more than the threshold below
+ * the baseline, and still is after its workload is measured a second time.
+ *
+ * Throughput depends on the machine, so the baseline records the machine it was
+ * measured on. Against a baseline from another machine, the changes are still
+ * printed but do not make the run fail.
+ *
+ * Every generated file must fit in memory, so large workloads are split over
+ * several files. gen_workload refuses a file that does not fit, and the run
+ * then fails rather than measure a program with wrapped addresses.
+ *
+ * Usage: ./run_bench [-t threshold_percent] <baseline_file>
+ *        ./run_bench --update <baseline_file>
+ *
+ * Returns 1 if any phase regressed on the baseline's machine or the assembler
+ * failed, 0 otherwise. With --update, the results and the machine are written
+ * to the baseline file instead of compared against it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <sys/utsname.h>
+
+#define BENCH_RUNS 9
+#define FILE_PASSES 20 /* Each run assembles the files this many times, so the phases are long enough to time */
+#define PHASE_ROWS 5 /* The four phases and the total */
+#define MAX_FILES 50
+#define MAX_LINE_LENGTH 300
+#define MAX_COMMAND_LENGTH 32768
+#define MAX_MACHINE_LENGTH 256
+#define MACHINE_PREFIX "# machine: "
+#define MAX_BASELINE_ENTRIES 64
+#define DEFAULT_THRESHOLD 20.0
+
+/**
+ * @brief A generated workload: gen_workload arguments and the number of files to split it into.
+ */
+typedef struct {
+    const char *name;
+    const char *arguments; /* Arguments for gen_workload, without the seed */
+    int files;             /* Each file gets its own seed */
+} Workload;
+
+/**
+ * @brief One entry of the baseline file.
+ */
+typedef struct {
+    char workload[32];
+    char phase[32];
+    double lines_per_second;
+} BaselineEntry;
+
+static const Workload workloads[] = {
+    {"label-heavy", "-n 500 -m 0 -e 0 -d 1", 8},
+    {"macro-heavy", "-n 50 -m 50 -k 20", 4},
+    {"extern-heavy", "-n 80 -e 50 -r 20", 4},
+    {"data-heavy", "-n 100 -m 0 -e 0 -d 200", 4},
+    {"many-small-files", "-n 20 -m 2 -k 3 -e 2 -r 2 -d 5", MAX_FILES}
+};
+
+/* Names of the rows of the time report, and the keys used for them in the baseline file */
+static const char *phase_rows[PHASE_ROWS] = {"Pre-assembly", "First pass", "Second pass", "Output", "Total"};
+static const char *phase_keys[PHASE_ROWS] = {"pre-assembly", "first-pass", "second-pass", "output", "total"};
+
+/**
+ * Describes the machine the benchmark runs on: operating system, architecture,
+ * processor model and number of online processors.
+ * @param machine Buffer of MAX_MACHINE_LENGTH characters for the description.
+ */
+static void describe_machine(char *machine) {
+    struct utsname system_name;
+    char model[MAX_LINE_LENGTH] = "unknown";
+    if (uname(&system_name) != 0) {
+        strcpy(system_name.sysname, "unknown");
+        strcpy(system_name.machine, "unknown");
+    }
+    FILE *cpuinfo = fopen("/proc/cpuinfo", "r");
+    if (cpuinfo) {
+        char line[MAX_LINE_LENGTH];
+        while (fgets(line, sizeof(line), cpuinfo)) {
+            char *value = strchr(line, ':');
+            if (strncmp(line, "model name", 10) == 0 && value) {
+                value += strspn(value + 1, " \t") + 1;
+                value[strcspn(value, "\n")] = '\0';
+                strncpy(model, value, sizeof(model) - 1);
+                break;
+            }
+        }
+        fclose(cpuinfo);
+    }
+    snprintf(machine, MAX_MACHINE_LENGTH, "%s %s, %.80s, %ld CPUs", system_name.sysname, system_name.machine,
+             model, sysconf(_SC_NPROCESSORS_ONLN));
+}
+
+/**
+ * Generates the input files of a workload as bench_run_<index>.as.
+ * @param workload The workload to generate.
+ * @return true if every file was generated, false otherwise.
+ */
+static bool generate_workload(const Workload *workload) {
+    char command[MAX_COMMAND_LENGTH];
+    for (int i = 0; i < workload->files; i++) {
+        snprintf(command, sizeof(command), "./gen_workload %s -s %d > bench_run_%d.as",
+                 workload->arguments, i + 1, i);
+        if (system(command) != 0) {
+            fprintf(stderr, "run_bench: failed to generate %s\n", workload->name);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Removes the generated input files of a workload and the assembler output for them.
+ * @param workload The workload to clean up.
+ */
+static void remove_workload(const Workload *workload) {
+    static const char *extensions[] = {".as", ".am", ".ob", ".ent", ".ext"};
+    char filename[64];
+    for (int i = 0; i < workload->files; i++) {
+        for (size_t j = 0; j < sizeof(extensions) / sizeof(extensions[0]); j++) {
+            snprintf(filename, sizeof(filename), "bench_run_%d%s", i, extensions[j]);
+            remove(filename);
+        }
+    }
+}
+
+/**
+ * Runs the assembler once over the files of a workload, FILE_PASSES times each, and computes
+ * the lines per second of CPU time of each phase from the "all files" time report.
+ * @param workload The workload to run.
+ * @param lines_per_second Set to the throughput of each row of the report.
+ * @return true if the report was read, false otherwise.
+ */
+static bool run_assembler(const Workload *workload, double lines_per_second[PHASE_ROWS]) {
+    char command[MAX_COMMAND_LENGTH] = "./assembler --time-report";
+    for (int pass = 0; pass < FILE_PASSES; pass++) {
+        for (int i = 0; i < workload->files; i++) {
+            size_t length = strlen(command);
+            snprintf(command + length, sizeof(command) - length, " bench_run_%d", i);
+        }
+    }
+
+    FILE *report = popen(command, "r");
+    if (!report) {
+        return false;
+    }
+    char line[MAX_LINE_LENGTH];
+    bool in_totals = false;
+    long total_lines = 0;
+    int rows = 0;
+    while (fgets(line, sizeof(line), report)) {
+        /* The title is "Time report for all files (<files> files, <lines> lines, <bytes> bytes)" */
+        if (sscanf(line, "Time report for all files (%*d %*s %ld lines", &total_lines) == 1) {
+            in_totals = true;
+            continue;
+        }
+        if (!in_totals || rows == PHASE_ROWS) continue;
+        /* Rows are "<name padded to 13> wall_ms cpu_ms lines_per_second bytes_per_second" */
+        for (int row = 0; row < PHASE_ROWS; row++) {
+            double wall, cpu, lines, bytes;
+            if (strncmp(line, phase_rows[row], strlen(phase_rows[row])) == 0 &&
+                sscanf(line + 13, "%lf %lf %lf %lf", &wall, &cpu, &lines, &bytes) == 4) {
+                lines_per_second[row] = cpu > 0 ? total_lines * 1e3 / cpu : 0;
+                rows++;
+            }
+        }
+    }
+    bool assembled = pclose(report) == 0;
+    return assembled && rows == PHASE_ROWS;
+}
+
+/**
+ * Measures the best throughput of each phase over BENCH_RUNS runs of a workload.
+ * @param workload The workload to measure.
+ * @param best Raised to the highest lines per second of each row of the report, so
+ *             measuring again keeps the best of both measurements.
+ * @return true if every run succeeded, false otherwise.
+ */
+static bool measure_workload(const Workload *workload, double best[PHASE_ROWS]) {
+    if (!generate_workload(workload)) {
+        remove_workload(workload);
+        return false;
+    }
+    bool ok = true;
+    for (int run = 0; run < BENCH_RUNS && ok; run++) {
+        double lines_per_second[PHASE_ROWS];
+        ok = run_assembler(workload, lines_per_second);
+        for (int row = 0; row < PHASE_ROWS && ok; row++) {
+            if (lines_per_second[row] > best[row]) {
+                best[row] = lines_per_second[row];
+            }
+        }
+    }
+    remove_workload(workload);
+    if (!ok) {
+        fprintf(stderr, "run_bench: assembler failed on %s\n", workload->name);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Reads the baseline file: one "workload phase lines_per_second" entry per line, '#' comments.
+ * The machine the baseline was measured on is given by a "# machine: " comment.
+ * @param filename The name of the baseline file.
+ * @param entries Array to fill.
+ * @param machine Buffer of MAX_MACHINE_LENGTH characters, set to the machine or left empty.
+ * @return The number of entries read, or -1 if the file cannot be opened.
+ */
+static int read_baseline(const char *filename, BaselineEntry entries[MAX_BASELINE_ENTRIES], char *machine) {
+    FILE *file = fopen(filename, "r");
+    if (!file) {
+        return -1;
+    }
+    char line[MAX_LINE_LENGTH];
+    int count = 0;
+    machine[0] = '\0';
+    while (fgets(line, sizeof(line), file) && count < MAX_BASELINE_ENTRIES) {
+        BaselineEntry *entry = &entries[count];
+        if (strncmp(line, MACHINE_PREFIX, strlen(MACHINE_PREFIX)) == 0) {
+            line[strcspn(line, "\n")] = '\0';
+            strncpy(machine, line + strlen(MACHINE_PREFIX), MAX_MACHINE_LENGTH - 1);
+            machine[MAX_MACHINE_LENGTH - 1] = '\0';
+            continue;
+        }
+        if (line[0] != '#' &&
+            sscanf(line, "%31s %31s %lf", entry->workload, entry->phase, &entry->lines_per_second) == 3) {
+            count++;
+        }
+    }
+    fclose(file);
+    return count;
+}
+
+/**
+ * Finds the baseline throughput of a workload phase.
+ * @param entries The baseline entries.
+ * @param count The number of entries.
+ * @param workload The name of the workload.
+ * @param phase The baseline key of the phase.
+ * @return The baseline lines per second, or 0 if there is none.
+ */
+static double find_baseline(const BaselineEntry *entries, int count, const char *workload, const char *phase) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(entries[i].workload, workload) == 0 && strcmp(entries[i].phase, phase) == 0) {
+            return entries[i].lines_per_second;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Checks if any phase of a workload is more than the threshold below its baseline.
+ * @param entries The baseline entries.
+ * @param count The number of entries.
+ * @param workload The name of the workload.
+ * @param best The measured lines per second of each row of the report.
+ * @param threshold The regression threshold in percent.
+ * @return true if a phase is slower than the threshold allows, false otherwise.
+ */
+static bool is_workload_slower(const BaselineEntry *entries, int count, const char *workload,
+                               const double best[PHASE_ROWS], double threshold) {
+    for (int row = 0; row < PHASE_ROWS; row++) {
+        double expected = find_baseline(entries, count, workload, phase_keys[row]);
+        if (expected > 0 && (best[row] - expected) / expected * 100 < -threshold) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char *argv[]) {
+    double threshold = DEFAULT_THRESHOLD;
+    bool update = false;
+    const char *baseline_filename = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--update") == 0) {
+            update = true;
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            threshold = atof(argv[++i]);
+        } else {
+            baseline_filename = argv[i];
+        }
+    }
+    if (!baseline_filename) {
+        fprintf(stderr, "Usage: %s [-t threshold_percent] [--update] <baseline_file>\n", argv[0]);
+        return 1;
+    }
+
+    char machine[MAX_MACHINE_LENGTH];
+    char baseline_machine[MAX_MACHINE_LENGTH] = "";
+    describe_machine(machine);
+    BaselineEntry baseline[MAX_BASELINE_ENTRIES];
+    int baseline_count = update ? 0 : read_baseline(baseline_filename, baseline, baseline_machine);
+    if (baseline_count == -1) {
+        fprintf(stderr, "run_bench: cannot read %s; run make bench-baseline first\n", baseline_filename);
+        return 1;
+    }
+    bool same_machine = strcmp(machine, baseline_machine) == 0;
+
+    FILE *output = NULL;
+    if (update) {
+        output = fopen(baseline_filename, "w");
+        if (!output) {
+            fprintf(stderr, "run_bench: cannot write %s\n", baseline_filename);
+            return 1;
+        }
+        fprintf(output, "# Best lines of source per second of CPU time over %d runs.\n", BENCH_RUNS);
+        fprintf(output, "# Written by make bench-baseline; compared by make bench.\n");
+        fprintf(output, "%s%s\n", MACHINE_PREFIX, machine);
+    } else {
+        printf("Best of %d runs, regression threshold %.0f%%\n", BENCH_RUNS, threshold);
+        if (!same_machine) {
+            printf("Baseline machine: %s\n", baseline_machine[0] != '\0' ? baseline_machine : "not recorded");
+            printf("This machine:     %s\n", machine);
+            printf("Changes are shown for information only; run make bench-baseline on this machine to gate on them\n");
+        }
+        printf("%-17s %-13s %12s %12s %8s\n", "Workload", "Phase", "Lines/s", "Baseline", "Change");
+    }
+
+    int regressions = 0;
+    bool failed = false;
+    for (size_t w = 0; w < sizeof(workloads) / sizeof(workloads[0]); w++) {
+        double best[PHASE_ROWS] = {0};
+        if (!measure_workload(&workloads[w], best)) {
+            failed = true;
+            continue;
+        }
+        /* A slow phase is measured again before it counts, since one busy period can slow every run */
+        if (!update && same_machine &&
+            is_workload_slower(baseline, baseline_count, workloads[w].name, best, threshold) &&
+            !measure_workload(&workloads[w], best)) {
+            failed = true;
+            continue;
+        }
+        for (int row = 0; row < PHASE_ROWS; row++) {
+            if (update) {
+                fprintf(output, "%s %s %.0f\n", workloads[w].name, phase_keys[row], best[row]);
+                continue;
+            }
+            double expected = find_baseline(baseline, baseline_count, workloads[w].name, phase_keys[row]);
+            if (expected <= 0) {
+                printf("%-17s %-13s %12.0f %12s %8s\n", workloads[w].name, phase_rows[row], best[row], "-", "-");
+                continue;
+            }
+            double change = (best[row] - expected) / expected * 100;
+            bool slower = change < -threshold;
+            bool regressed = same_machine && slower;
+            printf("%-17s %-13s %12.0f %12.0f %+7.1f%%%s\n", workloads[w].name, phase_rows[row], best[row],
+                   expected, change, regressed ? "  REGRESSION" : slower ? "  slower" : "");
+            regressions += regressed;
+        }
+    }
+
+    if (update) {
+        fclose(output);
+        printf("Baseline written to %s\n", baseline_filename);
+    } else {
+        printf("%d regression%s\n", regressions, regressions == 1 ? "" : "s");
+    }
+    return failed || regressions > 0 ? 1 : 0;
+}
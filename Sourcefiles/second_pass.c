@@ -7,6 +7,27 @@
 #include "opcode_table.h"
 #include "output_generator.h"
 #include "error_handling.h"
+#include "pre_assembler.h"
+#include "line_map.h"
+#include "options.h"
+#include "time_report.h"
+
+/**
+ * Records the words emitted for one line of the expanded file in the line map,
+ * translating the .am line number back to its origin in the original .as file.
+ * @param line_map Pointer to the line map being built.
+ * @param start_address The first address emitted for the line.
+ * @param length The number of words emitted for the line.
+ * @param line_number The line number in the expanded file.
+ */
+static void record_line(LineMap *line_map, int start_address, int length, int line_number) {
+    if (!assembler_options.emit_line_map) return;
+    LineOrigin origin = {line_number, 0};
+    if (line_number >= 1 && line_number <= line_origins.count) {
+        origin = line_origins.origins[line_number - 1];
+    }
+    add_line_range(line_map, start_address, length, origin.source_line, origin.expansion_line);
+}
 
 /**
  * Performs the second pass of the assembler. It processes the input file again,
@@ -18,9 +39,17 @@
  * @return true if the second pass was successful, false if errors were encountered.
  */
 bool second_pass(const char *filename, SymbolTable *symbol_table, int IC, int DC) {
+    char temp_filename[MAX_FILENAME + 8];
+    strncpy(temp_filename, filename, MAX_FILENAME);
+    temp_filename[MAX_FILENAME] = '\0';
+    char *dot = strrchr(temp_filename, '.');
+    if (dot) *dot = '\0';
+    strcat(temp_filename, ".ob.tmp"); /* Per-file name so several assemblers can share a directory */
+
     FILE *file = fopen(filename, "r");
-    FILE *ob_file = fopen("temp.ob", "w");
-    if (!file || !ob_file) {
+    FILE *ob_file = fopen(temp_filename, "w");
+    FILE *data_file = tmpfile(); /* Data words are collected here and placed after the code */
+    if (!file || !ob_file || !data_file) {
         log_error(ERR_FILE_INPUT, "Failed to open input or output file", filename, 0);
         return false;
     }
@@ -28,7 +57,14 @@ bool second_pass(const char *filename, SymbolTable *symbol_table, int IC, int DC
     char line[MAX_LINE_LENGTH + 1];
     int line_number = 0;
     int address = FIRST_ADDRESS;
+    int data_address = IC; /* Data follows the code, as the first pass assigned its symbols */
     bool error_found = false;
+    LineMap line_map = {0};
+    LineMap data_line_map = {0};
+    if (assembler_options.emit_line_map) {
+        init_line_map(&line_map);
+        init_line_map(&data_line_map);
+    }
 
     /* Process each line of the input file */
     while (fgets(line, sizeof(line), file)) {
@@ -49,11 +85,16 @@ bool second_pass(const char *filename, SymbolTable *symbol_table, int IC, int DC
         /* Handle data and string directives */
         if (strcmp(token, ".data") == 0 || strcmp(token, ".string") == 0) {
             char *operands = strtok(NULL, "\n");
+            int start_address = data_address;
             if (strcmp(token, ".data") == 0) {
-                write_data(ob_file, operands, &address);
+                if (!write_data(data_file, operands, &data_address, symbol_table)) {
+                    log_error(ERR_SYNTAX, "Invalid .data value", filename, line_number);
+                    error_found = true;
+                }
             } else {
-                write_string(ob_file, operands, &address);
+                write_string(data_file, operands, &data_address);
             }
+            record_line(&data_line_map, start_address, data_address - start_address, line_number);
             continue;
         }
 
@@ -92,20 +133,40 @@ bool second_pass(const char *filename, SymbolTable *symbol_table, int IC, int DC
             } else {
                 /* Write the encoded instruction to the object file */
                 write_instruction(ob_file, inst, address);
-                address += get_instruction_length(token, operands);
+                int length = get_instruction_length(token, operands);
+                record_line(&line_map, address, length, line_number);
+                address += length;
             }
         }
     }
 
+    /* Append the data section after the code */
+    rewind(data_file);
+    while (fgets(line, sizeof(line), data_file)) {
+        fputs(line, ob_file);
+    }
+    for (int i = 0; i < data_line_map.count; i++) {
+        const LineRange *range = &data_line_map.ranges[i];
+        add_line_range(&line_map, range->start_address, range->end_address - range->start_address + 1,
+                       range->source_line, range->expansion_line);
+    }
+    free_line_map(&data_line_map);
+
     fclose(file);
     fclose(ob_file);
+    fclose(data_file);
 
     if (error_found) {
         printf("Errors found during second pass. Assembly process halted.\n");
+        remove(temp_filename);
+        free_line_map(&line_map);
         return false;
     }
 
     /* Generate final output files */
-    generate_output(filename, symbol_table, IC, DC);
+    start_phase(PHASE_OUTPUT);
+    generate_output(filename, symbol_table, IC, DC, assembler_options.emit_line_map ? &line_map : NULL);
+    end_phase();
+    free_line_map(&line_map);
     return true;
 }
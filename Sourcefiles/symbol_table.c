@@ -5,6 +5,7 @@
 #include "symbol_table.h"
 #include "pre_assembler.h"
 #include "error_handling.h"
+#include "alloc_stats.h"
 
 /**
  * Initializes the symbol table with default values and allocates initial memory.
@@ -15,7 +16,7 @@ void init_symbol_table(SymbolTable *table) {
     table->capacity = 10;
     table->has_entries = false;
     table->has_externs = false;
-    table->symbols = malloc(sizeof(Symbol) * table->capacity);
+    table->symbols = counted_malloc(sizeof(Symbol) * table->capacity);
     init_external_table(&table->external_table);
 }
 
@@ -53,7 +54,7 @@ bool add_symbol(SymbolTable *table, const char *name, int address, SymbolType ty
     /* Resize the symbol table if necessary */
     if (table->size == table->capacity) {
         table->capacity *= 2;
-        table->symbols = realloc(table->symbols, sizeof(Symbol) * table->capacity);
+        table->symbols = counted_realloc(table->symbols, sizeof(Symbol) * table->capacity);
         if (table->symbols == NULL) {
             log_error(ERR_MEMORY, "Failed to resize symbol table", filename, line_number);
             return false;
@@ -97,7 +98,7 @@ Symbol *find_symbol(SymbolTable *table, const char *name) {
  * @param table Pointer to the symbol table to free.
  */
 void free_symbol_table(SymbolTable *table) {
-    free(table->symbols);
+    counted_free(table->symbols);
     table->size = 0;
     table->capacity = 0;
 }
@@ -107,7 +108,7 @@ void free_symbol_table(SymbolTable *table) {
  * @param table Pointer to the external table to initialize.
  */
 void init_external_table(ExternalTable *table) {
-    table->externals = malloc(sizeof(ExternalSymbol) * 10);
+    table->externals = counted_malloc(sizeof(ExternalSymbol) * 10);
     table->count = 0;
     table->capacity = 10;
 }
@@ -131,7 +132,7 @@ void add_external_reference(ExternalTable *table, const char *name, int address)
 
     if (table->count == table->capacity) {
         table->capacity *= 2;
-        table->externals = realloc(table->externals, sizeof(ExternalSymbol) * table->capacity);
+        table->externals = counted_realloc(table->externals, sizeof(ExternalSymbol) * table->capacity);
     }
 
     strcpy(table->externals[table->count].name, name);
@@ -145,7 +146,7 @@ void add_external_reference(ExternalTable *table, const char *name, int address)
  * @param table Pointer to the external table to free.
  */
 void free_external_table(ExternalTable *table) {
-    free(table->externals);
+    counted_free(table->externals);
     table->count = 0;
     table->capacity = 0;
 }
@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <time.h>
+#include "time_report.h"
+
+#define MAX_PHASE_DEPTH 8
+
+TimeReport phase_times = {{0}};
+
+static const char *phase_names[PHASE_COUNT] = {"Pre-assembly", "First pass", "Second pass", "Output"};
+
+static Phase phase_stack[MAX_PHASE_DEPTH]; /* Running phases, innermost last */
+static int phase_depth = 0;
+static double segment_wall = 0;            /* When the innermost phase last started or resumed */
+static double segment_cpu = 0;
+
+/**
+ * Reads a clock in seconds.
+ * @param clock_id The clock to read.
+ * @return The time in seconds.
+ */
+static double read_clock(clockid_t clock_id) {
+    struct timespec now;
+    clock_gettime(clock_id, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+ * Charges the time since the last phase change to the innermost running phase.
+ */
+static void charge_current_phase(void) {
+    double wall = read_clock(CLOCK_MONOTONIC);
+    double cpu = read_clock(CLOCK_PROCESS_CPUTIME_ID);
+    if (phase_depth > 0 && phase_depth <= MAX_PHASE_DEPTH) {
+        Phase phase = phase_stack[phase_depth - 1];
+        phase_times.wall_seconds[phase] += wall - segment_wall;
+        phase_times.cpu_seconds[phase] += cpu - segment_cpu;
+    }
+    segment_wall = wall;
+    segment_cpu = cpu;
+}
+
+/**
+ * Clears a time report.
+ * @param report Pointer to the report to clear.
+ */
+void reset_time_report(TimeReport *report) {
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        report->wall_seconds[phase] = 0;
+        report->cpu_seconds[phase] = 0;
+    }
+    report->lines = 0;
+    report->bytes = 0;
+    report->files = 0;
+}
+
+/**
+ * Starts timing a phase. The phase that was running is paused until end_phase().
+ * @param phase The phase that starts.
+ */
+void start_phase(Phase phase) {
+    charge_current_phase();
+    if (phase_depth < MAX_PHASE_DEPTH) {
+        phase_stack[phase_depth] = phase;
+    }
+    phase_depth++;
+}
+
+/**
+ * Stops timing the current phase and resumes the phase that was running before it.
+ */
+void end_phase(void) {
+    charge_current_phase();
+    if (phase_depth > 0) {
+        phase_depth--;
+    }
+}
+
+/**
+ * Returns the innermost running phase, so other reports can attribute work to it.
+ * @return The phase, or PHASE_COUNT if no phase is running.
+ */
+Phase get_current_phase(void) {
+    if (phase_depth == 0 || phase_depth > MAX_PHASE_DEPTH) {
+        return PHASE_COUNT;
+    }
+    return phase_stack[phase_depth - 1];
+}
+
+/**
+ * Counts the lines and bytes of a source file into a report.
+ * @param filename The name of the source file.
+ * @param report Pointer to the report to update.
+ * @return true if the file could be read, false otherwise.
+ */
+bool measure_source(const char *filename, TimeReport *report) {
+    FILE *file = fopen(filename, "r");
+    if (!file) {
+        return false;
+    }
+    int c;
+    int last = '\n';
+    while ((c = fgetc(file)) != EOF) {
+        report->bytes++;
+        if (c == '\n') report->lines++;
+        last = c;
+    }
+    if (last != '\n') report->lines++; /* Last line without a newline */
+    fclose(file);
+    report->files++;
+    return true;
+}
+
+/**
+ * Adds the times and sizes of one report to another.
+ * @param total Pointer to the report to add to.
+ * @param report Pointer to the report to add.
+ */
+void add_time_report(TimeReport *total, const TimeReport *report) {
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        total->wall_seconds[phase] += report->wall_seconds[phase];
+        total->cpu_seconds[phase] += report->cpu_seconds[phase];
+    }
+    total->lines += report->lines;
+    total->bytes += report->bytes;
+    total->files += report->files;
+}
+
+/**
+ * Prints one row of a time report. Rates are over wall time, and 0 if no time was measured.
+ * @param name The name of the row.
+ * @param wall The wall time in seconds.
+ * @param cpu The CPU time in seconds.
+ * @param lines The lines of source processed.
+ * @param bytes The bytes of source processed.
+ */
+static void print_time_row(const char *name, double wall, double cpu, long lines, long bytes) {
+    double lines_per_second = wall > 0 ? lines / wall : 0;
+    double bytes_per_second = wall > 0 ? bytes / wall : 0;
+    printf("%-13s %10.3f %10.3f %12.0f %12.0f\n", name, wall * 1e3, cpu * 1e3, lines_per_second, bytes_per_second);
+}
+
+/**
+ * Prints a time report: wall and CPU milliseconds per phase, with the lines and bytes
+ * of source per second of wall time each phase would sustain on its own.
+ * @param report Pointer to the report to print.
+ * @param title What the report is for, such as a file name.
+ */
+void print_time_report(const TimeReport *report, const char *title) {
+    double wall = 0, cpu = 0;
+
+    printf("Time report for %s (%d file%s, %ld lines, %ld bytes)\n", title, report->files,
+           report->files == 1 ? "" : "s", report->lines, report->bytes);
+    printf("%-13s %10s %10s %12s %12s\n", "Phase", "Wall ms", "CPU ms", "Lines/s", "Bytes/s");
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        print_time_row(phase_names[phase], report->wall_seconds[phase], report->cpu_seconds[phase],
+                       report->lines, report->bytes);
+        wall += report->wall_seconds[phase];
+        cpu += report->cpu_seconds[phase];
+    }
+    print_time_row("Total", wall, cpu, report->lines, report->bytes);
+}
@@ -6,6 +6,8 @@
 #include "symbol_table.h"
 #include "opcode_table.h"
 #include "error_handling.h"
+#include "isa_tables.h"
+#include "expression.h"
 
 /* Function implementations */
 
@@ -74,7 +76,7 @@ bool is_directive(const char *token) {
 int get_addressing_mode(const char *operand) {
     if (operand == NULL || operand[0] == '\0' || (operand[0] == ' ' && operand[1] == '\0'))
        return 4; /* No operand, empty string, or just a space */
-    if (operand[0] == '#' && is_number(operand)) return 0;  /* Immediate */
+    if (operand[0] == '#' && operand[1] != '\0') return 0;  /* Immediate, a number or constant expression */
     if (operand[0] == 'r' && is_register(operand)) return 3;  /* Register direct */
     if (operand[0] == '*' && operand[1] == 'r' && is_register(operand + 1)) return 2;  /* Register indirect */
     return 1;  /* Direct (label) */
@@ -94,15 +96,9 @@ int get_instruction_length(const char *operation, const char *operands) {
     int length = 1;  
     int operand_count = 0;
     if (operands != NULL) {
-        char source[MAX_LABEL_LENGTH + 1] = {0};
-        char target[MAX_LABEL_LENGTH + 1] = {0};
-        /*
-         * Parse the operands string to separate source and target operands.
-         * The %[^,] format specifier reads until a comma is encountered.
-         */
-        sscanf(operands, "%[^,], %s", source, target);
-        trim(source);
-        trim(target);           
+        char source[MAX_LINE_LENGTH + 1];
+        char target[MAX_LINE_LENGTH + 1];
+        split_operands(operands, source, target);
         int source_mode = get_addressing_mode(source);
         int target_mode = get_addressing_mode(target);
         /* Adds extra words for operands that need them */
@@ -131,6 +127,56 @@ int get_instruction_length(const char *operation, const char *operands) {
     return length;
 }
 
+/**
+ * @brief Split the operands of an instruction into source and target.
+ *
+ * If there is only one operand, it is the target and the source is left empty.
+ * Operands may be expressions, so the buffers are sized for a whole line.
+ *
+ * @param operands The operands part of the instruction, or NULL.
+ * @param source Buffer of MAX_LINE_LENGTH + 1 characters for the source operand.
+ * @param target Buffer of MAX_LINE_LENGTH + 1 characters for the target operand.
+ * @return true if both operands fit in their buffers, false if one was cut short.
+ */
+bool split_operands(const char *operands, char *source, char *target) {
+    bool fits = true;
+    source[0] = '\0';
+    target[0] = '\0';
+    if (operands != NULL) {
+        const char *comma = strchr(operands, ',');
+        size_t source_length = comma ? (size_t)(comma - operands) : strlen(operands);
+        fits = source_length <= MAX_LINE_LENGTH && (!comma || strlen(comma + 1) <= MAX_LINE_LENGTH);
+        sscanf(operands, "%80[^,], %80s", source, target);
+        trim(source);
+        trim(target);
+    }
+    /* If there's only one operand, treat it as the target */
+    if (target[0] == '\0') {
+        strcpy(target, source);
+        source[0] = '\0';
+    }
+    return fits;
+}
+
+/**
+ * @brief Check if an instruction's addressing modes are allowed for its opcode.
+ *
+ * The legal combinations are precomputed in encoding_table, so this is a single lookup.
+ *
+ * @param operation The operation part of the instruction.
+ * @param operands The operands part of the instruction.
+ * @return true if the addressing modes are legal, false otherwise.
+ */
+bool is_legal_addressing(const char *operation, const char *operands) {
+    int opcode = get_opcode(operation);
+    if (opcode == -1) return false;
+
+    char source[MAX_LINE_LENGTH + 1];
+    char target[MAX_LINE_LENGTH + 1];
+    split_operands(operands, source, target);
+    return encoding_table[opcode][get_addressing_mode(source)][get_addressing_mode(target)].legal;
+}
+
 /**
  * @brief Count the number of data values in a data directive.
  * 
@@ -166,28 +212,21 @@ Instruction encode_instruction(const char *operation, const char *operands, Symb
     Instruction inst = {0};
     inst.opcode = get_opcode(operation);
     
-    char source[MAX_LABEL_LENGTH + 1] = {0};
-    char target[MAX_LABEL_LENGTH + 1] = {0};
-    if (operands != NULL) {
-        sscanf(operands, "%[^,], %s", source, target);
-        trim(source);
-        trim(target);
-    }
-    /* If there's only one operand, treat it as the target */
-    if (target[0] == '\0') {
-        strcpy(target, source);
-        source[0] = '\0';
-    }
+    char source[MAX_LINE_LENGTH + 1];
+    char target[MAX_LINE_LENGTH + 1];
+    split_operands(operands, source, target);
     inst.source_addressing = get_addressing_mode(source);
     inst.target_addressing = get_addressing_mode(target);
 
     /* Set A.R.E field for the main instruction word */
     inst.are = 4; 
     unsigned int source_are = 4, target_are = 4;
+    /* The target word follows the source word, if there is one */
+    int target_address = address + (inst.source_addressing != 4 ? 2 : 1);
     if (inst.source_addressing != 4) /* There are only 4 methods from 0 to 3, if it 4 so it is not method */
-    inst.source_operand = encode_operand(source, symbol_table, &source_are, address, true);
+    inst.source_operand = encode_operand(source, symbol_table, &source_are, address + 1);
     if (inst.target_addressing != 4)
-    inst.target_operand = encode_operand(target, symbol_table, &target_are, address, false);
+    inst.target_operand = encode_operand(target, symbol_table, &target_are, target_address);
     if (inst.target_operand == -1 || inst.source_operand == -1)
     inst.opcode = -1;
 
@@ -202,11 +241,10 @@ Instruction encode_instruction(const char *operation, const char *operands, Symb
  * @param operand The operand to encode.
  * @param symbol_table Pointer to the symbol table.
  * @param are Pointer to the A.R.E. value.
- * @param address The current address.
- * @param is_source True if this is the source operand, false if it's the target.
+ * @param word_address The address of the word that will hold the operand, recorded for externals.
  * @return The encoded operand value.
  */
-int encode_operand(const char *operand, SymbolTable *symbol_table, unsigned int *are, int address, bool is_source) {
+int encode_operand(const char *operand, SymbolTable *symbol_table, unsigned int *are, int word_address) {
 
     /* Get the addressing mode of the operand */
     int mode = get_addressing_mode(operand);
@@ -214,7 +252,14 @@ int encode_operand(const char *operand, SymbolTable *symbol_table, unsigned int
         case 0: 
             /* Immediate addressing mode */
             *are = 4; /* Set A.R.E. to absolute */
-            return atoi(operand + 1) & 0xFFF; /* Convert to integer and mask to 12 bits */
+            {
+                /* The word is absolute, so a value that depends on a label address cannot be relocated */
+                ExpressionValue result;
+                if (!evaluate_expression(operand + 1, symbol_table, &result) || result.relocations != 0) {
+                    return -1;
+                }
+                return result.value & 0xFFF; /* Fold to an integer and mask to 12 bits */
+            }
 
         case 1: 
             /* Direct addressing mode */
@@ -224,13 +269,21 @@ int encode_operand(const char *operand, SymbolTable *symbol_table, unsigned int
                     if (symbol->type == SYMBOL_TYPE_EXTERNAL) {
                         /* Handle external symbol */
                         *are = 1; /* Set A.R.E. to external */
-                        add_external_reference(&symbol_table->external_table, operand, address + (is_source ? 1 : 2));
+                        add_external_reference(&symbol_table->external_table, operand, word_address);
                         return 1; /* Return 1 for external symbols */
                     } else {
                         /* Handle internal symbol */
                         *are = 2; /* Set A.R.E. to relocatable */
                         return symbol->address;
                     }
+                } else if (is_expression(operand)) {
+                    /* Address expression such as LABEL+3; it must still be one relocatable address */
+                    ExpressionValue result;
+                    if (!evaluate_expression(operand, symbol_table, &result) || result.relocations != 1) {
+                        return -1;
+                    }
+                    *are = 2; /* Set A.R.E. to relocatable */
+                    return result.value & 0xFFF;
                 } else {
                     /* Symbol not found in the symbol table */
                     return -1;
@@ -261,16 +314,9 @@ int encode_operand(const char *operand, SymbolTable *symbol_table, unsigned int
  * @param address The address of the instruction.
  */
 void write_instruction(FILE *file, Instruction inst, int address) {
-    unsigned int first_word = 0;   
-    first_word |= (inst.opcode & 0xF) << 11; /* Opcode encoding starting from bit 11 */
-    if (inst.source_addressing != 4) {
-        first_word |= (1 << (7 + inst.source_addressing)); /* Starting from the bit 7 that represent the source method */
-    }
-    if (inst.target_addressing != 4) {
-       first_word |= (1 << (3 + inst.target_addressing)); /* Starting from the bit 3 that represent the target method */
-    }   
-    first_word |= 4; /* The A.R.E is always 4 in first word */
-    fprintf(file, "%04d %05o\n", address, first_word & 0x7FFF);
+    /* The first word (opcode, addressing mode bits and A.R.E.) is precomputed per combination */
+    unsigned int first_word = encoding_table[inst.opcode & 0xF][inst.source_addressing][inst.target_addressing].first_word;
+    fprintf(file, "%04d %05o\n", address, first_word);
 
     int add_words = 1;
     /* Handle additional words for operands */
@@ -288,6 +334,10 @@ void write_instruction(FILE *file, Instruction inst, int address) {
             if (inst.source_are == 1) { /* Handle external */
                 source_word |= inst.source_are & 0x7; 
             }
+            else if (inst.source_addressing == 0) { /* Immediate */
+                source_word = (inst.source_operand & 0xFFF) << 3;
+                source_word |= 4;
+            }
             else if (inst.source_addressing == 1) { /* Direct */
                source_word = (inst.source_operand & 0xFFF) << 3;
                source_word |= inst.source_are & 0x7; /* Use provided A.R.E. */
@@ -346,18 +396,30 @@ bool is_number(const char* str) {
 /**
  * @brief Write data values to a file.
  *
+ * Each value may be a number or a constant expression such as END-START. Data words have
+ * no A.R.E. field, so a value that depends on a label address cannot be relocated and is
+ * rejected.
+ *
  * @param file The file to write to.
  * @param data The data string to write.
  * @param address Pointer to the current address (will be updated).
+ * @param symbol_table Pointer to the symbol table, for labels in expressions.
+ * @return true if every value was valid, false otherwise.
  */
-void write_data(FILE *file, const char *data, int *address) {
+bool write_data(FILE *file, const char *data, int *address, SymbolTable *symbol_table) {
+    bool valid = true;
     char *token = strtok((char *)data, ",");
     while (token != NULL) {
-        int value = atoi(token);
-        fprintf(file, "%04d %05o\n", *address, (unsigned short)value & 0x7FFF);
+        /* Values may be constant expressions; an invalid one still takes its word */
+        ExpressionValue result = {0, 0};
+        if (!evaluate_expression(token, symbol_table, &result) || result.relocations != 0) {
+            valid = false;
+        }
+        fprintf(file, "%04d %05o\n", *address, (unsigned short)result.value & 0x7FFF);
         (*address)++;
         token = strtok(NULL, ",");
     }
+    return valid;
 }
 
 /**
@@ -0,0 +1,10 @@
+.extern EXT
+MAIN: mov EXT+1, r1
+    prn #EXT*2
+    prn #MAIN*2
+    prn #VALS-1
+    lea EXT-MAIN, r2
+    stop
+VALS: .data 5, MAIN
+BAD: .data 3+, END+1, x
+END: .data EXT-1, 2*
@@ -0,0 +1,8 @@
+; Operands whose addressing mode the instruction does not allow
+MAIN: lea r1, r2
+    mov r1, #3
+    jmp r3
+    add *r1, #0
+    lea #5, r2
+    bne #1
+    stop
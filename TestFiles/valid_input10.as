@@ -0,0 +1,18 @@
+; Expected outputs were produced with: ./assembler --cost-report valid_input10
+; valid_input10.cost holds the report it prints, from "Cost report" to "Total".
+.entry MAIN
+MAIN: mov #3, COUNT
+    lea TABLE, r2
+LOOP: add *r2, r1
+    inc r2
+    dec COUNT
+    bne LOOP
+    jsr SHOW
+    stop
+SHOW: prn r1
+    red r3
+    not r3
+    cmp r3, TABLE
+    rts
+COUNT: .data 0
+TABLE: .data 5, 6, 7
@@ -0,0 +1,14 @@
+; Constant expressions in operands and .data values
+.entry MAIN
+.extern PRINT
+MAIN: mov TABLE+2, r1
+    add #END*2-START*2, r1
+    cmp #END-START, r1
+    lea TABLE+1, r2
+    jsr PRINT
+START: prn #-3+5*2
+    inc TABLE+3
+END: stop
+A: .data 5
+TABLE: .data 4, 8, 15, 16
+SIZE: .data END-START, 3*4-1, -2*3
@@ -0,0 +1,9 @@
+; Expected outputs were produced with: ./assembler -O1 valid_input5
+; The jmp target is an address expression, so -O1 must leave the code as it is.
+.entry MAIN
+MAIN: mov #0, r1
+    jmp L+1
+L: stop
+    inc r2
+    add #0, r2
+    stop
@@ -0,0 +1,12 @@
+; Expected outputs were produced with: ./assembler -O1 valid_input6
+.entry MAIN
+MAIN: mov #0, COUNT
+    mov r1, r1
+    add #0, r2
+    sub #0, COUNT
+    mov #0, r3
+    jmp NEXT
+NEXT: prn COUNT
+    mov r2, r3
+    stop
+COUNT: .data 4
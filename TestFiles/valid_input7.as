@@ -0,0 +1,20 @@
+; Expected outputs were produced with: ./assembler -O1 valid_input7
+macr finish
+    prn r1
+    stop
+    inc r2
+    prn r2
+endmacr
+macr report
+    prn #1
+    prn #2
+endmacr
+.entry MAIN
+MAIN: mov #5, r1
+    finish
+    report
+LOOP: dec r1
+    bne LOOP
+    rts
+    report
+    jmp MAIN
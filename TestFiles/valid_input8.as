@@ -0,0 +1,17 @@
+; Expected outputs were produced with: ./assembler --pool-data valid_input8
+.entry MAIN
+MAIN: prn MSG1
+    prn MSG2
+    prn MSG3
+    inc COUNT
+    lea TAB, r1
+    stop
+MSG1: .string "hello"
+MSG2: .string "hello"
+MSG3: .string "bye"
+COUNT: .data 0
+    .data 7, 7
+TAB: .data 0
+LIST: .data 1, 2
+    .data 7, 7
+    .string "bye"
@@ -0,0 +1,16 @@
+; Expected outputs were produced with: ./assembler --line-map valid_input9
+macr show
+    prn r1
+    prn #2
+endmacr
+.entry MAIN
+.extern OUT
+MAIN: mov LIST, r1
+    show
+LOOP: dec r1
+    bne LOOP
+    jsr OUT
+    show
+    stop
+LIST: .data 3, 4
+MSG: .string "ab"